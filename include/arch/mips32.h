@@ -152,6 +152,7 @@ namespace mips32
 	#define INST_OPCODE_ANDI 0x0c
 	#define INST_OPCODE_OR   0x00
 	#define INST_OPCODE_ORI  0x0d
+	#define INST_OPCODE_LUI  0x0f
 	#define INST_OPCODE_XOR  0x00
 	#define INST_OPCODE_NOR  0x00
 	#define INST_OPCODE_SLT  0x00
@@ -30,6 +30,7 @@
 
 // Ours
 #include <assembler.h>
+#include <disassembler.h>
 
 /**
  * @brief MIPS-32
@@ -87,6 +88,7 @@ namespace mips32
 	#define INST_NAME_ANDI "andi"
 	#define INST_NAME_OR   "or"
 	#define INST_NAME_ORI  "ori"
+	#define INST_NAME_LUI  "lui"
 	#define INST_NAME_XOR  "xor"
 	#define INST_NAME_NOR  "nor"
 	#define INST_NAME_SLT  "slt"
@@ -102,6 +104,35 @@ namespace mips32
 	#define INST_NAME_JAL  "jal"
 	/**@}*/
 
+	/**
+	 * @name Name of Pseudo-Instructions
+	 */
+	/**@{*/
+	#define INST_NAME_NOP  "nop"
+	#define INST_NAME_MOVE "move"
+	#define INST_NAME_NOT  "not"
+	#define INST_NAME_NEG  "neg"
+	#define INST_NAME_LI   "li"
+	#define INST_NAME_LA   "la"
+	#define INST_NAME_B    "b"
+	#define INST_NAME_BEQZ "beqz"
+	#define INST_NAME_BNEZ "bnez"
+	#define INST_NAME_BLT  "blt"
+	#define INST_NAME_BGE  "bge"
+	#define INST_NAME_BGT  "bgt"
+	#define INST_NAME_BLE  "ble"
+	/**@}*/
+
+	/**
+	 * @name Relocation Types
+	 */
+	/**@{*/
+	#define RELOC_MIPS32_PC16 (RELOC_ARCH + 0) /**< Branch offset.  */
+	#define RELOC_MIPS32_26   (RELOC_ARCH + 1) /**< Jump target.    */
+	#define RELOC_MIPS32_HI16 (RELOC_ARCH + 2) /**< Upper half.     */
+	#define RELOC_MIPS32_LO16 (RELOC_ARCH + 3) /**< Lower half.     */
+	/**@}*/
+
 	/**
 	 * @brief MIPS-32 Assembler
 	 */
@@ -113,10 +144,58 @@ namespace mips32
 			 * @brief Encodes an instruction.
 			 *
 			 * @param inst Tokenized instruction.
+			 * @param ref  Where to store a reference to a symbol.
 			 *
 			 * @param The machine code for the target instruction.
 			 */
-			isa32::word_t encode_instruction(const std::vector<const char *> &inst) override;
+			isa32::word_t encode_instruction(const Tokens &inst, Reference &ref) const override;
+
+			/**
+			 * @brief Encodes an instruction or a pseudo-instruction.
+			 *
+			 * @details Pseudo-instructions expand to the shortest
+			 * sequence: li loads a constant with a single addi or ori
+			 * when it fits in 16 bits, and with lui, followed by ori
+			 * only if the lower half is not zero, otherwise. la loads
+			 * a symbol with lui and ori. The compare-and-branch
+			 * pseudo-instructions (blt, bge, bgt and ble) compute the
+			 * condition in $at, and numeric targets are offsets from
+			 * the branch that they expand to.
+			 */
+			size_t expand_instruction(const Tokens &inst, isa32::word_t *words, Reference *refs) const override;
+
+			/**
+			 * @brief Patches an instruction with the address of a symbol.
+			 *
+			 * @details Branches take the offset in words from the delay
+			 * slot, jumps the word address within its 256 MB region,
+			 * and lui and ori the upper and lower halves of the address.
+			 */
+			isa32::word_t relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const override;
+
+			/**
+			 * @brief Gets the name of the assembled language.
+			 */
+			const char *name(void) const override;
+	};
+
+	/**
+	 * @brief MIPS-32 Disassembler
+	 *
+	 * @details Decodes through tables indexed by opcode and, for R-type
+	 * instructions, by function. Fields are read as laid out by the
+	 * MIPS32 architecture. Mips32Assembler places the data register of
+	 * lw and sw in rd rather than rt, so these two do not assemble back
+	 * into the same words.
+	 */
+	class Mips32Disassembler : public Disassembler
+	{
+		public:
+
+			/**
+			 * @brief Formats an instruction.
+			 */
+			void format(isa32::word_t inst, TextBuffer &out) const override;
 	};
 }
 
@@ -0,0 +1,628 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef ASM_RV32_H_
+#define ASM_RV32_H_
+
+// Theirs
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// Ours
+#include <assembler.h>
+#include <disassembler.h>
+#include <perfecthash.h>
+#include <vmachine/isa.h>
+
+/**
+ * @brief RISC-V 32-bit
+ */
+namespace rv32
+{
+	/**
+	 * @name Relocation Types
+	 */
+	/**@{*/
+	#define RELOC_RV32_BRANCH (RELOC_ARCH + 0) /**< B-type offset. */
+	#define RELOC_RV32_JAL    (RELOC_ARCH + 1) /**< J-type offset. */
+	/**@}*/
+
+	/**
+	 * @brief Instruction information.
+	 */
+	class Instruction
+	{
+		public:
+
+			isa32::word_t bits;
+			isa32::word_t(*encode)(const Instruction &i, const Tokens &tokens, Reference &ref);
+	};
+
+
+	/**
+	 * @brief Builds the fixed bits of an instruction.
+	 *
+	 * @param opcode  Operation code.
+	 * @param funct_3 Function 3.
+	 * @param funct_7 Function 7.
+	 */
+	constexpr isa32::word_t bits(isa32::word_t opcode, isa32::word_t funct_3, isa32::word_t funct_7 = 0)
+	{
+		return (
+			((opcode & INST_MASK_OPCODE))                        |
+			((funct_3 & INST_MASK_FUNCT_3) << INST_SHIFT_FUNCT_3) |
+			((funct_7 & INST_MASK_FUNCT_7) << INST_SHIFT_FUNCT_7)
+		);
+	}
+
+	//==============================================================================
+	// Lookup Tables
+	//==============================================================================
+
+	// Map of Registers
+	inline constexpr auto registers = makePerfectHash<uint32_t>({
+		{ "x0",  REG_0  }, { "x1",  REG_1  }, { "x2",  REG_2  }, { "x3",  REG_3  },
+		{ "x4",  REG_4  }, { "x5",  REG_5  }, { "x6",  REG_6  }, { "x7",  REG_7  },
+		{ "x8",  REG_8  }, { "x9",  REG_9  }, { "x10", REG_10 }, { "x11", REG_11 },
+		{ "x12", REG_12 }, { "x13", REG_13 }, { "x14", REG_14 }, { "x15", REG_15 },
+		{ "x16", REG_16 }, { "x17", REG_17 }, { "x18", REG_18 }, { "x19", REG_19 },
+		{ "x20", REG_20 }, { "x21", REG_21 }, { "x22", REG_22 }, { "x23", REG_23 },
+		{ "x24", REG_24 }, { "x25", REG_25 }, { "x26", REG_26 }, { "x27", REG_27 },
+		{ "x28", REG_28 }, { "x29", REG_29 }, { "x30", REG_30 }, { "x31", REG_31 },
+		{ "zero", REG_0  }, { "ra",  REG_1  }, { "sp",  REG_2  }, { "gp",  REG_3  },
+		{ "tp",   REG_4  }, { "t0",  REG_5  }, { "t1",  REG_6  }, { "t2",  REG_7  },
+		{ "s0",   REG_8  }, { "fp",  REG_8  }, { "s1",  REG_9  }, { "a0",  REG_10 },
+		{ "a1",   REG_11 }, { "a2",  REG_12 }, { "a3",  REG_13 }, { "a4",  REG_14 },
+		{ "a5",   REG_15 }, { "a6",  REG_16 }, { "a7",  REG_17 }, { "s2",  REG_18 },
+		{ "s3",   REG_19 }, { "s4",  REG_20 }, { "s5",  REG_21 }, { "s6",  REG_22 },
+		{ "s7",   REG_23 }, { "s8",  REG_24 }, { "s9",  REG_25 }, { "s10", REG_26 },
+		{ "s11",  REG_27 }, { "t3",  REG_28 }, { "t4",  REG_29 }, { "t5",  REG_30 },
+		{ "t6",   REG_31 },
+	});
+
+	//==============================================================================
+	// Encoding Functions
+	//==============================================================================
+
+	/**
+	 * @brief Looks up a token in a table.
+	 *
+	 * @param table Target table.
+	 * @param token Target token.
+	 * @param what  What is looked up, for error messages.
+	 *
+	 * @returns The matching entry.
+	 */
+	template<typename T, std::size_t N>
+	constexpr const T &lookup(const PerfectHash<T, N> &table, std::string_view token, const char *what)
+	{
+		const T *value = table.find(token);
+
+		if (value == nullptr)
+			throw std::invalid_argument(what);
+
+		return (*value);
+	}
+
+	/**
+	 * @brief Parses a signed immediate.
+	 *
+	 * @param token Target token.
+	 * @param bits  Width of the immediate.
+	 *
+	 * @returns The immediate.
+	 */
+	constexpr int32_t parse(std::string_view token, unsigned bits)
+	{
+		isa32::word_t value = 0;
+
+		if (!parseNumber(token, value))
+			throw std::invalid_argument("invalid immediate");
+
+		int32_t imm = static_cast<int32_t>(value);
+		if ((imm < -(1 << (bits - 1))) || (imm >= (1 << (bits - 1))))
+			throw std::range_error("immediate out of range");
+
+		return (imm);
+	}
+
+	/**
+	 * @brief Parses a branch or jump target.
+	 *
+	 * @param token Target token.
+	 * @param type  Relocation type of a reference.
+	 * @param ref   Where to store the reference.
+	 *
+	 * @returns The offset, or zero for a reference.
+	 */
+	constexpr int32_t parse(std::string_view token, unsigned type, Reference &ref)
+	{
+		isa32::word_t value = 0;
+
+		if (parseNumber(token, value))
+			return (static_cast<int32_t>(value));
+
+		if (!isSymbol(token))
+			throw std::invalid_argument("invalid operand");
+
+		ref.type = type;
+		ref.symbol = token;
+
+		return (0);
+	}
+
+	/**
+	 * @brief Scatters a branch offset into B-type immediate bits.
+	 */
+	constexpr isa32::word_t immediateB(int32_t offset)
+	{
+		if ((offset & 1) || (offset < -4096) || (offset > 4095))
+			throw std::range_error("branch out of range");
+
+		isa32::word_t imm = static_cast<isa32::word_t>(offset);
+
+		return (
+			(((imm >> 12) & 0x01) << 31) |
+			(((imm >> 5)  & 0x3f) << 25) |
+			(((imm >> 1)  & 0x0f) << 8)  |
+			(((imm >> 11) & 0x01) << 7)
+		);
+	}
+
+	/**
+	 * @brief Scatters a jump offset into J-type immediate bits.
+	 */
+	constexpr isa32::word_t immediateJ(int32_t offset)
+	{
+		if ((offset & 1) || (offset < -(1 << 20)) || (offset >= (1 << 20)))
+			throw std::range_error("jump out of range");
+
+		isa32::word_t imm = static_cast<isa32::word_t>(offset);
+
+		return (
+			(((imm >> 20) & 0x001) << 31) |
+			(((imm >> 1)  & 0x3ff) << 21) |
+			(((imm >> 11) & 0x001) << 20) |
+			(((imm >> 12) & 0x0ff) << 12)
+		);
+	}
+
+	/**
+	 * @brief Encodes a R-type instruction (rd, rs1, rs2).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_R(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t rs1 = lookup(registers, tokens[2], "unknown register");
+		isa32::word_t rs2 = lookup(registers, tokens[3], "unknown register");
+
+		return (
+			i.bits                        |
+			(rd << INST_SHIFT_RD)         |
+			(rs1 << INST_SHIFT_RS_1)      |
+			(rs2 << INST_SHIFT_RS_2)
+		);
+	}
+
+	/**
+	 * @brief Encodes an I-type instruction (rd, rs1, imm).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_I(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t rs1 = lookup(registers, tokens[2], "unknown register");
+		isa32::word_t imm = parse(tokens[3], 12);
+
+		return (
+			i.bits                                                          |
+			(rd << INST_SHIFT_RD)                                           |
+			(rs1 << INST_SHIFT_RS_1)                                        |
+			((imm & INST_MASK_IMMEDIATE_I_TYPE) << INST_SHIFT_IMMEDIATE_I_TYPE)
+		);
+	}
+
+	/**
+	 * @brief Encodes a shift I-type instruction (rd, rs1, shamt).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_I_shift(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t rs1 = lookup(registers, tokens[2], "unknown register");
+		isa32::word_t value = 0;
+
+		if (!parseNumber(tokens[3], value))
+			throw std::invalid_argument("invalid immediate");
+		if (value > 31)
+			throw std::range_error("shift out of range");
+
+		return (
+			i.bits                        |
+			(rd << INST_SHIFT_RD)         |
+			(rs1 << INST_SHIFT_RS_1)      |
+			(value << INST_SHIFT_RS_2)
+		);
+	}
+
+	/**
+	 * @brief Encodes a load or jalr I-type instruction (rd, imm(rs1)).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_I_mem(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t imm = parse(tokens[2], 12);
+		isa32::word_t rs1 = lookup(registers, tokens[3], "unknown register");
+
+		return (
+			i.bits                                                          |
+			(rd << INST_SHIFT_RD)                                           |
+			(rs1 << INST_SHIFT_RS_1)                                        |
+			((imm & INST_MASK_IMMEDIATE_I_TYPE) << INST_SHIFT_IMMEDIATE_I_TYPE)
+		);
+	}
+
+	/**
+	 * @brief Encodes a S-type instruction (rs2, imm(rs1)).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_S(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rs2 = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t imm = parse(tokens[2], 12);
+		isa32::word_t rs1 = lookup(registers, tokens[3], "unknown register");
+
+		return (
+			i.bits                                                |
+			((imm & 0x1f) << INST_SHIFT_RD)                       |
+			(rs1 << INST_SHIFT_RS_1)                              |
+			(rs2 << INST_SHIFT_RS_2)                              |
+			(((imm >> 5) & INST_MASK_FUNCT_7) << INST_SHIFT_FUNCT_7)
+		);
+	}
+
+	/**
+	 * @brief Encodes a B-type instruction (rs1, rs2, target).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_B(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		isa32::word_t rs1 = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t rs2 = lookup(registers, tokens[2], "unknown register");
+		int32_t offset = parse(tokens[3], RELOC_RV32_BRANCH, ref);
+
+		return (
+			i.bits                        |
+			(rs1 << INST_SHIFT_RS_1)      |
+			(rs2 << INST_SHIFT_RS_2)      |
+			immediateB(offset)
+		);
+	}
+
+	/**
+	 * @brief Encodes a U-type instruction (rd, imm).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_U(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) ref);
+
+		isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+		isa32::word_t imm = 0;
+
+		if (!parseNumber(tokens[2], imm))
+			throw std::invalid_argument("invalid immediate");
+		if (imm > INST_MASK_IMMEDIATE)
+			throw std::range_error("immediate out of range");
+
+		return (
+			i.bits                        |
+			(rd << INST_SHIFT_RD)         |
+			(imm << INST_SHIFT_IMMEDIATE)
+		);
+	}
+
+	/**
+	 * @brief Encodes a J-type instruction ([rd,] target).
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_J(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		// The link register defaults to ra.
+		bool link = (tokens.size() > 2);
+		isa32::word_t rd = link ? lookup(registers, tokens[1], "unknown register") : REG_1;
+		int32_t offset = parse(tokens[link ? 2 : 1], RELOC_RV32_JAL, ref);
+
+		return (
+			i.bits                        |
+			(rd << INST_SHIFT_RD)         |
+			immediateJ(offset)
+		);
+	}
+
+	/**
+	 * @brief Encodes an instruction without operands.
+	 *
+	 * @param i      Instruction information.
+	 * @param tokens Instruction tokens.
+	 * @param ref    Where to store a reference to a symbol.
+	 *
+	 * @returns The encoded instruction.
+	 */
+	constexpr isa32::word_t encode_instruction_fixed(const Instruction &i, const Tokens &tokens, Reference &ref)
+	{
+		((void) tokens);
+		((void) ref);
+
+		return (i.bits);
+	}
+
+	//==============================================================================
+	// Instruction Table
+	//==============================================================================
+
+	// Map of Instructions
+	inline constexpr auto instructions = makePerfectHash<Instruction>({
+		{ "add",    { bits(R_TYPE_INSTRUCTIONS, INST_ADD_SUB_FUNCT_3, INST_ADD_FUNCT_7),  encode_instruction_R       } },
+		{ "sub",    { bits(R_TYPE_INSTRUCTIONS, INST_ADD_SUB_FUNCT_3, INST_SUB_FUNCT_7),  encode_instruction_R       } },
+		{ "sll",    { bits(R_TYPE_INSTRUCTIONS, INST_SLL_FUNCT_3,     INST_SLL_FUNCT_7),  encode_instruction_R       } },
+		{ "slt",    { bits(R_TYPE_INSTRUCTIONS, INST_SLT_FUNCT_3,     INST_SLT_FUNCT_7),  encode_instruction_R       } },
+		{ "sltu",   { bits(R_TYPE_INSTRUCTIONS, INST_SLTU_FUNCT_3,    INST_SLTU_FUNCT_7), encode_instruction_R       } },
+		{ "xor",    { bits(R_TYPE_INSTRUCTIONS, INST_XOR_FUNCT_3,     INST_XOR_FUNCT_7),  encode_instruction_R       } },
+		{ "srl",    { bits(R_TYPE_INSTRUCTIONS, INST_SRL_SRA_FUNCT_3, INST_SRL_FUNCT_7),  encode_instruction_R       } },
+		{ "sra",    { bits(R_TYPE_INSTRUCTIONS, INST_SRL_SRA_FUNCT_3, INST_SRA_FUNCT_7),  encode_instruction_R       } },
+		{ "or",     { bits(R_TYPE_INSTRUCTIONS, INST_OR_FUNCT_3,      INST_OR_FUNCT_7),   encode_instruction_R       } },
+		{ "and",    { bits(R_TYPE_INSTRUCTIONS, INST_AND_FUNCT_3,     INST_AND_FUNCT_7),  encode_instruction_R       } },
+		{ "addi",   { bits(INST_OPCODE_ADDI,    INST_ADDI_FUNCT_3),                       encode_instruction_I       } },
+		{ "slti",   { bits(INST_OPCODE_SLTI,    INST_SLTI_FUNCT_3),                       encode_instruction_I       } },
+		{ "sltiu",  { bits(INST_OPCODE_SLTIU,   INST_SLTIU_FUNCT_3),                      encode_instruction_I       } },
+		{ "xori",   { bits(INST_OPCODE_XORI,    INST_XORI_FUNCT_3),                       encode_instruction_I       } },
+		{ "ori",    { bits(INST_OPCODE_ORI,     INST_ORI_FUNCT_3),                        encode_instruction_I       } },
+		{ "andi",   { bits(INST_OPCODE_ANDI,    INST_ANDI_FUNCT_3),                       encode_instruction_I       } },
+		{ "slli",   { bits(INST_OPCODE_SLLI,    INST_SLLI_FUNCT_3,    INST_SLL_FUNCT_7),  encode_instruction_I_shift } },
+		{ "srli",   { bits(INST_OPCODE_SRLI,    INST_SRLI_FUNCT_3,    INST_SRL_FUNCT_7),  encode_instruction_I_shift } },
+		{ "srai",   { bits(INST_OPCODE_SRAI,    INST_SRAI_FUNCT_3,    INST_SRA_FUNCT_7),  encode_instruction_I_shift } },
+		{ "lb",     { bits(INST_OPCODE_LB,      INST_LB_FUNCT_3),                         encode_instruction_I_mem   } },
+		{ "lh",     { bits(INST_OPCODE_LH,      INST_LH_FUNCT_3),                         encode_instruction_I_mem   } },
+		{ "lw",     { bits(INST_OPCODE_LW,      INST_LW_FUNCT_3),                         encode_instruction_I_mem   } },
+		{ "lbu",    { bits(INST_OPCODE_LBU,     INST_LBU_FUNCT_3),                        encode_instruction_I_mem   } },
+		{ "lhu",    { bits(INST_OPCODE_LHU,     INST_LHU_FUNCT_3),                        encode_instruction_I_mem   } },
+		{ "jalr",   { bits(INST_OPCODE_JALR,    INST_JALR_FUNCT_3),                       encode_instruction_I_mem   } },
+		{ "sb",     { bits(S_TYPE_INSTRUCTIONS, INST_SB_FUNCT_3),                         encode_instruction_S       } },
+		{ "sh",     { bits(S_TYPE_INSTRUCTIONS, INST_SH_FUNCT_3),                         encode_instruction_S       } },
+		{ "sw",     { bits(S_TYPE_INSTRUCTIONS, INST_SW_FUNCT_3),                         encode_instruction_S       } },
+		{ "beq",    { bits(B_TYPE_INSTRUCTIONS, INST_BEQ_FUNCT_3),                        encode_instruction_B       } },
+		{ "bne",    { bits(B_TYPE_INSTRUCTIONS, INST_BNE_FUNCT_3),                        encode_instruction_B       } },
+		{ "blt",    { bits(B_TYPE_INSTRUCTIONS, INST_BLT_FUNCT_3),                        encode_instruction_B       } },
+		{ "bge",    { bits(B_TYPE_INSTRUCTIONS, INST_BGE_FUNCT_3),                        encode_instruction_B       } },
+		{ "bltu",   { bits(B_TYPE_INSTRUCTIONS, INST_BLTU_FUNCT_3),                       encode_instruction_B       } },
+		{ "bgeu",   { bits(B_TYPE_INSTRUCTIONS, INST_BGEU_FUNCT_3),                       encode_instruction_B       } },
+		{ "lui",    { bits(INST_OPCODE_LUI,     0),                                       encode_instruction_U       } },
+		{ "auipc",  { bits(INST_OPCODE_AUIPC,   0),                                       encode_instruction_U       } },
+		{ "jal",    { bits(INST_OPCODE_JAL,     0),                                       encode_instruction_J       } },
+		{ "fence",  { bits(INST_OPCODE_FENCE,   INST_FENCE_FUNCT_3) | (0x0ff << INST_SHIFT_IMMEDIATE_I_TYPE), encode_instruction_fixed } },
+		{ "ecall",  { bits(INST_OPCODE_ECALL,   INST_ECALL_FUNCT_3),                      encode_instruction_fixed   } },
+		{ "ebreak", { bits(INST_OPCODE_EBREAK,  INST_EBREAK_FUNCT_3) | (1 << INST_SHIFT_IMMEDIATE_I_TYPE),     encode_instruction_fixed } },
+	});
+
+	/**
+	 * @brief RV32I Encoding
+	 *
+	 * @details Encodes instructions and resolves references, also in
+	 * constant expressions. Rv32Assembler and assemble() share it.
+	 */
+	struct Encoding
+	{
+		/**
+		 * @brief Encodes an instruction.
+		 *
+		 * @param tokens Tokenized instruction.
+		 * @param ref    Where to store a reference to a symbol.
+		 *
+		 * @returns The encoded instruction.
+		 */
+		static constexpr isa32::word_t encode(const Tokens &tokens, Reference &ref)
+		{
+			const Instruction &i = lookup(instructions, tokens[0], "unknown instruction");
+
+			return (i.encode(i, tokens, ref));
+		}
+
+		/**
+		 * @brief Patches a word with the address of a symbol.
+		 *
+		 * @param word  Target word.
+		 * @param type  Relocation type.
+		 * @param pc    Address of @p word.
+		 * @param value Address of the symbol.
+		 *
+		 * @returns The patched word.
+		 */
+		static constexpr isa32::word_t relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value)
+		{
+			int32_t offset = static_cast<int32_t>(value - pc);
+
+			switch (type)
+			{
+				case RELOC_ABS32:
+					return (word + value);
+
+				case RELOC_RV32_BRANCH:
+					return (word | immediateB(offset));
+
+				case RELOC_RV32_JAL:
+					return (word | immediateJ(offset));
+
+				default:
+					throw std::invalid_argument("unknown relocation");
+			}
+		}
+	};
+
+	/**
+	 * @brief Counts the words of a source.
+	 *
+	 * @param source Target source.
+	 *
+	 * @returns The number of words that assemble() emits.
+	 */
+	constexpr size_t size(std::string_view source)
+	{
+		return (ConstantAssembler<Encoding>::size(source));
+	}
+
+	/**
+	 * @brief Assembles a source at compile time.
+	 *
+	 * @details See ConstantAssembler for what a source may hold.
+	 * Prefer RV32_ASSEMBLE(), which sizes the array itself.
+	 *
+	 * @tparam N Number of words, as counted by size().
+	 *
+	 * @param source Target source.
+	 * @param base   Address of the first word.
+	 *
+	 * @returns The words of the program.
+	 */
+	template<size_t N>
+	constexpr std::array<isa32::word_t, N> assemble(std::string_view source, isa32::word_t base = 0)
+	{
+		return (ConstantAssembler<Encoding>::assemble<N>(source, base));
+	}
+
+	/**
+	 * @brief Assembles a string literal into a std::array at compile time.
+	 */
+	#define RV32_ASSEMBLE(source) (rv32::assemble<rv32::size(source)>(source))
+
+	/**
+	 * @brief RV32I Assembler
+	 *
+	 * @details Assembles the RV32I base instruction set, in the encoding
+	 * executed by the virtual machine. Registers are named either x0 to
+	 * x31 or by their ABI names. Numeric branch and jump targets are
+	 * offsets in bytes from the instruction.
+	 */
+	class Rv32Assembler : public Assembler
+	{
+		public:
+
+			/**
+			 * @brief Encodes an instruction.
+			 *
+			 * @param inst Tokenized instruction.
+			 * @param ref  Where to store a reference to a symbol.
+			 *
+			 * @param The machine code for the target instruction.
+			 */
+			isa32::word_t encode_instruction(const Tokens &inst, Reference &ref) const override;
+
+			/**
+			 * @brief Patches an instruction with the address of a symbol.
+			 *
+			 * @details Branches and jumps take their offset from the
+			 * instruction itself.
+			 */
+			isa32::word_t relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const override;
+
+			/**
+			 * @brief Gets the name of the assembled language.
+			 */
+			const char *name(void) const override;
+	};
+
+	/**
+	 * @brief RV32I Disassembler
+	 *
+	 * @details Decodes through a table of major opcodes and tables of
+	 * names by funct3. Registers are shown by their ABI names, and
+	 * branch and jump targets as offsets in bytes.
+	 */
+	class Rv32Disassembler : public Disassembler
+	{
+		public:
+
+			/**
+			 * @brief Formats an instruction.
+			 */
+			void format(isa32::word_t inst, TextBuffer &out) const override;
+	};
+}
+
+#endif // ASM_RV32_H_
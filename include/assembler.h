@@ -26,28 +26,424 @@
 #define ASSEMBLER_H_
 
 // Theirs
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Ours
+#include <threadpool.h>
 #include <arch.h>
 
+/**
+ * @brief Assembler Version
+ *
+ * @details Bump whenever the encoding of any instruction changes, so
+ * that previously assembled programs are no longer reused.
+ */
+#define ASSEMBLER_VERSION 2
+
+/**
+ * @brief Size of Source Chunks Read at Once (in bytes)
+ */
+#define ASSEMBLER_CHUNK_SIZE (64*1024)
+
+/**
+ * @brief Maximum Number of Tokens in a Line
+ */
+#define ASSEMBLER_MAX_TOKENS 8
+
+/**
+ * @brief Number of Relocations Applied by a Single Linking Task
+ */
+#define ASSEMBLER_LINK_BLOCK 4096
+
+/**
+ * @brief Maximum Number of Words of an Instruction
+ *
+ * @details Pseudo-instructions may expand to several instructions.
+ */
+#define ASSEMBLER_MAX_EXPANSION 4
+
+/**
+ * @name Sections
+ */
+/**@{*/
+#define ASSEMBLER_SECTION_TEXT 0 /**< Instructions.       */
+#define ASSEMBLER_SECTION_DATA 1 /**< Data.               */
+#define ASSEMBLER_NR_SECTIONS  2 /**< Number of sections. */
+/**@}*/
+
+/**
+ * @name Relocation Types
+ *
+ * @details Architectures number their own types from #RELOC_ARCH on.
+ */
+/**@{*/
+#define RELOC_ABS32 0 /**< Absolute 32-bit address.          */
+#define RELOC_ARCH  1 /**< First architecture-specific type. */
+/**@}*/
+
+/**
+ * @brief Tokens of a Line
+ *
+ * @details Tokens are views into the line, stored in place: tokenizing
+ * a line never allocates.
+ */
+struct Tokens
+{
+	std::string_view token[ASSEMBLER_MAX_TOKENS]; /**< Tokens.           */
+	size_t count = 0;                             /**< Number of tokens. */
+
+	/**
+	 * @brief Gets a token (empty past the last one).
+	 */
+	constexpr std::string_view operator[](size_t i) const
+	{
+		return ((i < count) ? token[i] : std::string_view());
+	}
+
+	/**
+	 * @brief Gets the number of tokens.
+	 */
+	constexpr size_t size(void) const { return (count); }
+};
+
+/**
+ * @brief Asserts if a character separates tokens.
+ */
+constexpr bool isDelimiter(char c)
+{
+	return ((c == ' ') || (c == ',') || (c == '(') || (c == ')') ||
+	        (c == '\t') || (c == '\r') || (c == '\n'));
+}
+
+/**
+ * @brief Strips the # comment off a line.
+ */
+constexpr std::string_view uncomment(std::string_view line)
+{
+	return (line.substr(0, line.find('#')));
+}
+
+/**
+ * @brief Splits a source into lines.
+ *
+ * @param source Target source.
+ * @param fn     Consumer of each line.
+ */
+template<typename F>
+constexpr void splitLines(std::string_view source, F fn)
+{
+	for (size_t first = 0; first < source.size(); )
+	{
+		size_t last = source.find('\n', first);
+
+		if (last == std::string_view::npos)
+			last = source.size();
+
+		fn(source.substr(first, last - first));
+
+		first = last + 1;
+	}
+}
+
+/**
+ * @brief Splits a line into tokens.
+ *
+ * @param line   Target line.
+ * @param tokens Where to store the tokens.
+ *
+ * @returns False if the line has more than #ASSEMBLER_MAX_TOKENS tokens.
+ */
+constexpr bool tokenize(std::string_view line, Tokens &tokens)
+{
+	size_t i = 0;
+
+	tokens.count = 0;
+	while (true)
+	{
+		while ((i < line.size()) && isDelimiter(line[i]))
+			i++;
+		if (i == line.size())
+			return (true);
+
+		size_t first = i;
+		while ((i < line.size()) && !isDelimiter(line[i]))
+			i++;
+
+		if (tokens.count == ASSEMBLER_MAX_TOKENS)
+			return (false);
+		tokens.token[tokens.count++] = line.substr(first, i - first);
+	}
+}
+
+/**
+ * @brief Parses a number.
+ *
+ * @details Numbers are decimal, or hexadecimal with a 0x prefix, and
+ * may be negative.
+ *
+ * @param token Target token.
+ * @param value Where to store the number.
+ *
+ * @returns False if @p token is not a number.
+ *
+ * @throws std::range_error The number does not fit in 32 bits, either
+ * signed or unsigned.
+ */
+constexpr bool parseNumber(std::string_view token, isa32::word_t &value)
+{
+	uint64_t number = 0;
+	uint64_t base = 10;
+	bool negative = false;
+	size_t i = 0;
+
+	if ((i < token.size()) && (token[i] == '-'))
+	{
+		negative = true;
+		i++;
+	}
+	if ((token.substr(i, 2) == "0x") || (token.substr(i, 2) == "0X"))
+	{
+		base = 16;
+		i += 2;
+	}
+	if (i == token.size())
+		return (false);
+
+	for ( ; i < token.size(); i++)
+	{
+		char c = token[i];
+		uint64_t digit = 0;
+
+		if ((c >= '0') && (c <= '9'))
+			digit = c - '0';
+		else if ((c >= 'a') && (c <= 'f'))
+			digit = c - 'a' + 10;
+		else if ((c >= 'A') && (c <= 'F'))
+			digit = c - 'A' + 10;
+		else
+			return (false);
+
+		if (digit >= base)
+			return (false);
+
+		number = number*base + digit;
+		if (number > (negative ? UINT64_C(0x80000000) : UINT64_C(0xffffffff)))
+			throw std::range_error("number out of range");
+	}
+
+	value = static_cast<isa32::word_t>(negative ? -number : number);
+
+	return (true);
+}
+
+/**
+ * @brief Asserts if a name is a local label (e.g. 1).
+ */
+constexpr bool isLocalLabel(std::string_view name)
+{
+	if (name.empty())
+		return (false);
+
+	for (char c : name)
+	{
+		if ((c < '0') || (c > '9'))
+			return (false);
+	}
+
+	return (true);
+}
+
+/**
+ * @brief Asserts if a token refers to a local label (e.g. 1f or 1b).
+ */
+constexpr bool isLocalReference(std::string_view token)
+{
+	return (
+		(token.size() > 1)                                   &&
+		((token.back() == 'f') || (token.back() == 'b'))     &&
+		isLocalLabel(token.substr(0, token.size() - 1))
+	);
+}
+
+/**
+ * @brief Asserts if a token is a symbol.
+ */
+constexpr bool isSymbol(std::string_view token)
+{
+	if (token.empty())
+		return (false);
+	if (isLocalReference(token))
+		return (true);
+	if ((token[0] >= '0') && (token[0] <= '9'))
+		return (false);
+
+	for (char c : token)
+	{
+		bool ok = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+		          ((c >= '0') && (c <= '9')) || (c == '_') || (c == '.') || (c == '$');
+
+		if (!ok)
+			return (false);
+	}
+
+	return (true);
+}
+
+/**
+ * @brief Reference to a Symbol
+ *
+ * @details Filled in by an encoder when an operand names a symbol
+ * rather than a number.
+ */
+struct Reference
+{
+	unsigned type = RELOC_ABS32; /**< Relocation type.              */
+	std::string_view symbol;     /**< Symbol (empty if none).       */
+};
+
+/**
+ * @brief Location in a Section
+ */
+struct Location
+{
+	unsigned section; /**< Section.                 */
+	size_t offset;    /**< Offset (in words).       */
+};
+
+/**
+ * @brief Relocation
+ *
+ * @details References to local labels (e.g. 1f) keep the number of
+ * definitions of the label that precede them in @p ordinal.
+ */
+struct Relocation
+{
+	unsigned type;      /**< Relocation type.                   */
+	Location where;     /**< Word to patch.                     */
+	std::string symbol; /**< Target symbol.                     */
+	size_t ordinal;     /**< Preceding local definitions.       */
+};
+
+/**
+ * @brief Relocatable Object
+ */
+struct Object
+{
+	std::vector<isa32::word_t> sections[ASSEMBLER_NR_SECTIONS];          /**< Contents.     */
+	std::vector<Relocation> relocations;                                 /**< Relocations.  */
+	std::unordered_map<std::string, Location> labels;                    /**< Labels.       */
+	std::unordered_map<std::string, std::vector<Location>> locals;       /**< Local labels. */
+	std::unordered_set<std::string> globals;                             /**< Exported.     */
+};
+
+/**
+ * @brief Assembled Program
+ *
+ * @details Sections are laid out back to back from @p base, so the
+ * whole program is one contiguous buffer of words.
+ */
+struct Program
+{
+	/**
+	 * @brief Symbol
+	 */
+	struct Symbol
+	{
+		std::string name;    /**< Name.               */
+		isa32::word_t value; /**< Address.            */
+		isa32::word_t size;  /**< Size (in bytes).    */
+	};
+
+	isa32::word_t base = 0;           /**< Address of the first word.   */
+	isa32::word_t entry = 0;          /**< Entry point.                 */
+	size_t textSize = 0;              /**< Words of instructions.       */
+	std::vector<isa32::word_t> words; /**< Instructions, then data.     */
+	std::vector<Symbol> symbols;      /**< Symbols, sorted by address.  */
+};
+
 /**
  * @brief Assembler
+ *
+ * @details Assembling keeps no state in the assembler, so a single
+ * assembler may be used by several threads at once.
  */
 class Assembler
 {
 	private:
 
-		const char *delim = " ,()";
+		/**
+		 * @brief Reads a source in chunks of complete lines.
+		 *
+		 * @param input Stream to target input file.
+		 * @param fn    Consumer of each chunk.
+		 */
+		static void readChunks(std::istream &input, const std::function<void(std::string_view)> &fn);
+
+		/**
+		 * @brief Assembles a line.
+		 *
+		 * @param line  Target line.
+		 * @param words Where to store the encoded instructions
+		 * (#ASSEMBLER_MAX_EXPANSION at most).
+		 *
+		 * @returns The number of instructions, zero if the line is blank.
+		 */
+		size_t assembly(std::string_view line, isa32::word_t *words) const;
+
+		/**
+		 * @brief Assembles a line into an object.
+		 *
+		 * @param line    Target line.
+		 * @param obj     Target object.
+		 * @param section Current section, switched by directives.
+		 *
+		 * @returns True if the line is a section directive.
+		 */
+		bool assembly(std::string_view line, Object &obj, unsigned &section) const;
+
+		/**
+		 * @brief Assembles chunks of complete lines into an object.
+		 *
+		 * @param chunks Consecutive chunks of a source.
+		 * @param pool   Threads to assemble on.
+		 *
+		 * @returns The object, with symbol references left unresolved.
+		 */
+		Object assembleObject(const std::vector<std::string_view> &chunks, ThreadPool &pool) const;
 
 	public:
 
+		/**
+		 * @brief Consumer of assembled words.
+		 *
+		 * @param words Assembled words.
+		 * @param count Number of words.
+		 */
+		typedef std::function<void(const isa32::word_t *words, size_t count)> emit_fn;
+
 		/**
 		 * @brief Assembles a source file.
 		 *
-		 * @param file Stream to target input file.
+		 * @details The source is read in chunks of #ASSEMBLER_CHUNK_SIZE
+		 * bytes and tokenized in place. Each chunk is assembled into a
+		 * contiguous buffer that is handed over to @p emit at once. Blank
+		 * lines produce no words. Labels and directives are not
+		 * supported: see assemble() instead.
+		 *
+		 * @param input Stream to target input file.
+		 * @param emit  Consumer of the words of each chunk.
 		 */
-		void assembly(std::istream &input);
+		void assembly(std::istream &input, const emit_fn &emit) const;
 
 		/**
 		 * @brief Assembles a command.
@@ -55,13 +451,381 @@ class Assembler
 		 * @param line Command line.
 		 *
 		 * @returns The encoded instruction.
+		 *
+		 * @throws std::invalid_argument The command is a
+		 * pseudo-instruction that expands to several instructions.
+		 */
+		isa32::word_t assembly(std::string_view line) const;
+
+		/**
+		 * @brief Assembles a source file into a relocatable object.
+		 *
+		 * @details Lines may start with labels (name: or, for local
+		 * labels, a number such as 1:) and may end with a # comment.
+		 * Local labels are referred to as 1f (next definition) or 1b
+		 * (previous definition). The directives .text, .data, .word and
+		 * .space are supported, and .globl exports labels to other
+		 * objects.
+		 *
+		 * Chunks of #ASSEMBLER_CHUNK_SIZE bytes are assembled in
+		 * parallel, each into an object of its own, and concatenated.
+		 *
+		 * @param input Stream to target input file.
+		 * @param pool  Threads to assemble on.
+		 *
+		 * @returns The object, with symbol references left unresolved.
+		 */
+		Object assembleObject(std::istream &input, ThreadPool &pool = ThreadPool::instance()) const;
+
+		/**
+		 * @brief Assembles a source in memory into a relocatable object.
+		 *
+		 * @details As assembleObject(std::istream &, ThreadPool &), but
+		 * chunks are views into @p source, which is never copied.
+		 *
+		 * @param source Target source.
+		 * @param pool   Threads to assemble on.
+		 *
+		 * @returns The object, with symbol references left unresolved.
+		 */
+		Object assembleObject(std::string_view source, ThreadPool &pool = ThreadPool::instance()) const;
+
+		/**
+		 * @brief Lays out an object and resolves its references.
+		 *
+		 * @details The entry point is the _start symbol, if any, or
+		 * @p base otherwise.
+		 *
+		 * @param obj  Target object.
+		 * @param base Address of the first instruction.
+		 *
+		 * @returns The program.
+		 */
+		Program link(const Object &obj, isa32::word_t base = 0) const;
+
+		/**
+		 * @brief Links objects into a program.
+		 *
+		 * @details Text sections of all objects come first, in order,
+		 * then data sections. A reference resolves against the labels
+		 * of its own object first, then against the labels that any
+		 * object exports with .globl, through a hash index. Relocations
+		 * are applied in parallel, in blocks of #ASSEMBLER_LINK_BLOCK.
+		 *
+		 * The entry point is the exported _start symbol, if any, then
+		 * the _start label of the first object that has one, or @p base
+		 * otherwise.
+		 *
+		 * @param objects Target objects.
+		 * @param base    Address of the first instruction.
+		 * @param pool    Threads to link on.
+		 *
+		 * @returns The program.
+		 */
+		Program link(const std::vector<const Object *> &objects, isa32::word_t base = 0, ThreadPool &pool = ThreadPool::instance()) const;
+
+		/**
+		 * @brief Assembles a source file into a program.
+		 *
+		 * @param input Stream to target input file.
+		 * @param base  Address of the first instruction.
+		 * @param pool  Threads to assemble on.
+		 *
+		 * @returns The program.
 		 */
-		isa32::word_t assembly(std::string &line);
+		Program assemble(std::istream &input, isa32::word_t base = 0, ThreadPool &pool = ThreadPool::instance()) const;
+
+		/**
+		 * @brief Assembles a source in memory into a program.
+		 *
+		 * @param source Target source.
+		 * @param base   Address of the first instruction.
+		 * @param pool   Threads to assemble on.
+		 *
+		 * @returns The program.
+		 */
+		Program assemble(std::string_view source, isa32::word_t base = 0, ThreadPool &pool = ThreadPool::instance()) const;
 
 		/**
 		 * @brief Encodes a instruction.
+		 *
+		 * @param inst Tokenized instruction.
+		 * @param ref  Where to store a reference to a symbol, if an
+		 * operand names one. The operand is then encoded as zero.
+		 */
+		virtual isa32::word_t encode_instruction(const Tokens &inst, Reference &ref) const = 0;
+
+		/**
+		 * @brief Encodes an instruction, or the instructions of a
+		 * pseudo-instruction.
+		 *
+		 * @details Defaults to a single encode_instruction().
+		 *
+		 * @param inst  Tokenized instruction.
+		 * @param words Where to store the encoded instructions
+		 * (#ASSEMBLER_MAX_EXPANSION at most).
+		 * @param refs  Where to store a reference to a symbol, for
+		 * each instruction.
+		 *
+		 * @returns The number of instructions.
+		 */
+		virtual size_t expand_instruction(const Tokens &inst, isa32::word_t *words, Reference *refs) const;
+
+		/**
+		 * @brief Patches a word with the address of a symbol.
+		 *
+		 * @param word  Target word.
+		 * @param type  Relocation type.
+		 * @param pc    Address of @p word.
+		 * @param value Address of the symbol.
+		 *
+		 * @returns The patched word.
+		 */
+		virtual isa32::word_t relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const;
+
+		/**
+		 * @brief Gets the name of the assembled language.
+		 *
+		 * @details Names must be distinct across assemblers: assembled
+		 * programs are cached under the name and the version.
+		 */
+		virtual const char *name(void) const = 0;
+
+		/**
+		 * @brief Gets the version of the encoding.
+		 *
+		 * @details Defaults to #ASSEMBLER_VERSION.
+		 */
+		virtual unsigned version(void) const;
+};
+
+/**
+ * @brief Compile-time Assembler
+ *
+ * @details Assembles a source in a constant expression, so that guest
+ * programs embedded in the simulator are encoded and checked by the
+ * compiler. The source is a single section laid out from an address
+ * of choice. Labels, local labels, # comments, instructions and the
+ * directives .text, .globl, .word and .space are supported, as in
+ * Assembler::assembleObject(). Errors throw, which in a constant
+ * expression is a compile error.
+ *
+ * Symbols are looked up by scanning the source again, so this is meant
+ * for short programs.
+ *
+ * @tparam Encoding Provides static constexpr encode() and relocate(),
+ * with the meaning of Assembler::encode_instruction() and
+ * Assembler::relocate().
+ */
+template<typename Encoding>
+class ConstantAssembler
+{
+	private:
+
+		/**
+		 * @brief Walks over the labels and statements of a source.
+		 *
+		 * @param source    Target source.
+		 * @param label     Consumer of labels (line, offset, name).
+		 * @param statement Consumer of statements (line, offset, tokens).
+		 */
+		template<typename L, typename S>
+		static constexpr void scan(std::string_view source, L label, S statement)
+		{
+			size_t line = 0;
+			size_t offset = 0;
+
+			splitLines(source, [&](std::string_view text) {
+				Tokens tokens;
+
+				text = uncomment(text);
+				if (!tokenize(text, tokens))
+					throw std::invalid_argument("too many tokens");
+
+				// Labels.
+				while ((tokens.size() > 0) && (tokens[0].back() == ':'))
+				{
+					std::string_view name = tokens[0].substr(0, tokens[0].size() - 1);
+
+					if (!isLocalLabel(name) && !isSymbol(name))
+						throw std::invalid_argument("invalid or duplicate label");
+					label(line, offset, name);
+
+					text.remove_prefix(tokens[0].data() + tokens[0].size() - text.data());
+					tokenize(text, tokens);
+				}
+
+				if (tokens.size() > 0)
+				{
+					statement(line, offset, tokens);
+					offset += words(tokens);
+				}
+
+				line++;
+			});
+		}
+
+		/**
+		 * @brief Counts the words of a statement.
+		 */
+		static constexpr size_t words(const Tokens &tokens)
+		{
+			isa32::word_t size = 0;
+
+			if (tokens[0][0] != '.')
+				return (1);
+			if (tokens[0] == ".word")
+				return (tokens.size() - 1);
+			if (tokens[0] == ".space")
+			{
+				if (!parseNumber(tokens[1], size))
+					throw std::invalid_argument("invalid operand");
+
+				// Whole words only.
+				return ((size + sizeof(isa32::word_t) - 1)/sizeof(isa32::word_t));
+			}
+			if ((tokens[0] == ".text") || (tokens[0] == ".globl") || (tokens[0] == ".global"))
+				return (0);
+
+			throw std::invalid_argument("unknown directive");
+		}
+
+		/**
+		 * @brief Looks up the address of a symbol.
+		 *
+		 * @param source Target source.
+		 * @param symbol Target symbol.
+		 * @param line   Line that refers to @p symbol.
+		 * @param base   Address of the first word.
 		 */
-		virtual isa32::word_t encode_instruction(const std::vector<const char *> &inst) = 0;
+		static constexpr isa32::word_t address(std::string_view source, std::string_view symbol, size_t line, isa32::word_t base)
+		{
+			bool local = isLocalReference(symbol);
+			bool forward = local && (symbol.back() == 'f');
+			std::string_view name = local ? symbol.substr(0, symbol.size() - 1) : symbol;
+			bool found = false;
+			size_t offset = 0;
+
+			scan(source,
+				[&](size_t l, size_t o, std::string_view label) {
+					if (label != name)
+						return;
+
+					if (!local)
+					{
+						if (found)
+							throw std::invalid_argument("invalid or duplicate label");
+					}
+
+					// Next definition after the line, or last one up to it.
+					else if (forward ? (found || (l <= line)) : (l > line))
+						return;
+
+					found = true;
+					offset = o;
+				},
+				[](size_t, size_t, const Tokens &) { }
+			);
+
+			if (!found)
+				throw std::invalid_argument("undefined symbol");
+
+			return (base + offset*sizeof(isa32::word_t));
+		}
+
+	public:
+
+		/**
+		 * @brief Counts the words of a source.
+		 *
+		 * @param source Target source.
+		 *
+		 * @returns The number of words that assemble() emits.
+		 */
+		static constexpr size_t size(std::string_view source)
+		{
+			size_t count = 0;
+
+			scan(source,
+				[](size_t, size_t, std::string_view) { },
+				[&](size_t, size_t, const Tokens &tokens) { count += words(tokens); }
+			);
+
+			return (count);
+		}
+
+		/**
+		 * @brief Assembles a source.
+		 *
+		 * @tparam N Number of words, as counted by size().
+		 *
+		 * @param source Target source.
+		 * @param base   Address of the first word.
+		 *
+		 * @returns The words of the program.
+		 */
+		template<size_t N>
+		static constexpr std::array<isa32::word_t, N> assemble(std::string_view source, isa32::word_t base = 0)
+		{
+			std::array<isa32::word_t, N> program{};
+			size_t count = 0;
+
+			// Appends a word, resolving a reference in it.
+			auto emit = [&](size_t line, isa32::word_t word, const Reference &ref) {
+				if (count == N)
+					throw std::length_error("program larger than its array");
+
+				if (!ref.symbol.empty())
+				{
+					isa32::word_t pc = base + count*sizeof(isa32::word_t);
+					word = Encoding::relocate(word, ref.type, pc, address(source, ref.symbol, line, base));
+				}
+
+				program[count++] = word;
+			};
+
+			scan(source,
+				[](size_t, size_t, std::string_view) { },
+				[&](size_t line, size_t, const Tokens &tokens) {
+					// Instruction.
+					if (tokens[0][0] != '.')
+					{
+						Reference ref;
+						isa32::word_t inst = Encoding::encode(tokens, ref);
+
+						emit(line, inst, ref);
+					}
+
+					// Data.
+					else if (tokens[0] == ".word")
+					{
+						for (size_t i = 1; i < tokens.size(); i++)
+						{
+							isa32::word_t value = 0;
+							Reference ref;
+
+							if (!parseNumber(tokens[i], value))
+							{
+								if (!isSymbol(tokens[i]))
+									throw std::invalid_argument("invalid operand");
+								ref.symbol = tokens[i];
+							}
+							emit(line, value, ref);
+						}
+					}
+					else
+					{
+						for (size_t i = words(tokens); i > 0; i--)
+							emit(line, 0, Reference());
+					}
+				}
+			);
+
+			if (count != N)
+				throw std::length_error("program smaller than its array");
+
+			return (program);
+		}
 };
 
 #endif /* ASSEMBLER_H_ */
\ No newline at end of file
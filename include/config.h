@@ -30,9 +30,76 @@
      */
     #define VMACHINE_DEFAULT_MEMORY_SIZE 1024
 
+    /**
+     * @brief Page Size of Guest Memory (in bytes)
+     */
+    #define VMACHINE_PAGE_SIZE 4096
+
     /**
      * @brief Default Cache Memory Size (in bytes)
      */
     #define VMACHINE_DEFAULT_CACHE_SIZE 256
 
+    /**
+     * @brief Default Cache Associativity
+     */
+    #define VMACHINE_DEFAULT_CACHE_WAYS 4
+
+    /**
+     * @brief Default Cache Line Size (in bytes)
+     */
+    #define VMACHINE_DEFAULT_CACHE_LINE_SIZE 16
+
+    /**
+     * @brief Default Base Latency of an Instruction (in cycles)
+     */
+    #define VMACHINE_DEFAULT_CORE_LATENCY 1
+
+    /**
+     * @brief Default Cache Hit Latency (in cycles)
+     */
+    #define VMACHINE_DEFAULT_CACHE_LATENCY 2
+
+    /**
+     * @brief Default Memory Access Latency (in cycles)
+     */
+    #define VMACHINE_DEFAULT_MEMORY_LATENCY 100
+
+    /**
+     * @brief Default Prefetch Degree (lines per trigger)
+     */
+    #define VMACHINE_DEFAULT_PREFETCH_DEGREE 2
+
+    /**
+     * @brief Default Prefetch Distance (lines or strides ahead)
+     */
+    #define VMACHINE_DEFAULT_PREFETCH_DISTANCE 1
+
+    /**
+     * @brief Capacity of Prefetch Queues
+     */
+    #define VMACHINE_PREFETCH_QUEUE_SIZE 16
+
+    /**
+     * @brief Prefetches Issued per Demand Access
+     */
+    #define VMACHINE_PREFETCH_ISSUE_WIDTH 1
+
+    /**
+     * @brief Number of Worker Threads (0 for one per host CPU)
+     */
+    #define VMACHINE_THREADS 0
+
+    /**
+     * @brief Size of Pieces Read in Parallel by the Loader (in bytes)
+     */
+    #define VMACHINE_LOAD_CHUNK_SIZE (1024*1024)
+
+    /**
+     * @brief Default Directory of Assembled Programs
+     *
+     * @details Overridden by the VMACHINE_ASM_CACHE environment variable.
+     */
+    #define VMACHINE_ASM_CACHE_DIR "/tmp/vmachine-cache"
+
 #endif // CONFIG_H_
\ No newline at end of file
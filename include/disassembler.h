@@ -0,0 +1,219 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef DISASSEMBLER_H_
+#define DISASSEMBLER_H_
+
+// Theirs
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Ours
+#include <arch.h>
+
+/**
+ * @brief Longest Line of a Disassembled Instruction (with NUL)
+ */
+#define DISASSEMBLER_MAX_LINE 48
+
+/**
+ * @brief Text Buffer
+ *
+ * @details Appends text to a caller-provided buffer, never past its
+ * end. As with snprintf(), the length counts every character appended,
+ * including those that did not fit.
+ */
+class TextBuffer
+{
+	private:
+
+		char *buf_;     /**< Target buffer.          */
+		size_t size_;   /**< Size of target buffer.  */
+		size_t length_; /**< Length of the text.     */
+
+	public:
+
+		/**
+		 * @brief Creates a text buffer.
+		 *
+		 * @param buf  Target buffer.
+		 * @param size Size of the target buffer.
+		 */
+		TextBuffer(char *buf, size_t size) :
+			buf_(buf),
+			size_(size),
+			length_(0)
+		{
+		}
+
+		/**
+		 * @brief Appends a character.
+		 */
+		void put(char c)
+		{
+			if (length_ + 1 < size_)
+				buf_[length_] = c;
+			length_++;
+		}
+
+		/**
+		 * @brief Appends a string.
+		 */
+		void put(std::string_view str)
+		{
+			if (length_ + str.size() < size_)
+			{
+				memcpy(&buf_[length_], str.data(), str.size());
+				length_ += str.size();
+				return;
+			}
+
+			for (char c : str)
+				put(c);
+		}
+
+		/**
+		 * @brief Appends several characters or strings.
+		 */
+		template<typename T, typename U, typename... Rest>
+		void put(T first, U second, Rest... rest)
+		{
+			put(first);
+			put(second, rest...);
+		}
+
+		/**
+		 * @brief Appends a signed decimal number.
+		 */
+		void putDecimal(int32_t value)
+		{
+			char digits[11];
+			unsigned n = sizeof(digits);
+			uint32_t v = (value < 0) ? -static_cast<uint32_t>(value) : value;
+
+			do
+			{
+				digits[--n] = '0' + (v % 10);
+				v /= 10;
+			} while (v != 0);
+			if (value < 0)
+				digits[--n] = '-';
+
+			put(std::string_view(&digits[n], sizeof(digits) - n));
+		}
+
+		/**
+		 * @brief Appends a hexadecimal number with a 0x prefix.
+		 *
+		 * @param value Target number.
+		 * @param width Minimum number of digits.
+		 */
+		void putHex(uint32_t value, unsigned width = 1)
+		{
+			char digits[10];
+			unsigned n = 8;
+
+			while ((n > width) && ((value >> (4*(n - 1))) == 0))
+				n--;
+
+			digits[0] = '0';
+			digits[1] = 'x';
+			for (unsigned i = 0; i < n; i++)
+				digits[2 + i] = "0123456789abcdef"[(value >> (4*(n - 1 - i))) & 0xf];
+
+			put(std::string_view(digits, 2 + n));
+		}
+
+		/**
+		 * @brief Terminates the text.
+		 *
+		 * @returns The length of the text.
+		 */
+		size_t finish(void)
+		{
+			if (size_ > 0)
+				buf_[(length_ < size_) ? length_ : size_ - 1] = '\0';
+
+			return (length_);
+		}
+};
+
+/**
+ * @brief Disassembler
+ *
+ * @details Formats instructions in the syntax of the matching
+ * assembler. Fields are read as the architecture lays them out, so the
+ * text assembles back into the same words only where the assembler
+ * follows that layout too: see the disassembler of each architecture.
+ * Formatting keeps no state and never allocates.
+ */
+class Disassembler
+{
+	public:
+
+		/**
+		 * @brief Formats an instruction.
+		 *
+		 * @details Words that do not decode are formatted as a .word
+		 * directive.
+		 *
+		 * @param inst Target instruction.
+		 * @param out  Where to append the text.
+		 */
+		virtual void format(isa32::word_t inst, TextBuffer &out) const = 0;
+
+		/**
+		 * @brief Disassembles an instruction.
+		 *
+		 * @param inst Target instruction.
+		 * @param buf  Target buffer (#DISASSEMBLER_MAX_LINE bytes fit any
+		 * instruction).
+		 * @param size Size of the target buffer.
+		 *
+		 * @returns The length of the text, which was truncated if not
+		 * less than @p size.
+		 */
+		size_t disassemble(isa32::word_t inst, char *buf, size_t size) const;
+
+		/**
+		 * @brief Disassembles a range of memory.
+		 *
+		 * @details Writes one line per word, as the address followed by
+		 * the instruction.
+		 *
+		 * @param words Target words.
+		 * @param count Number of words.
+		 * @param base  Address of the first word.
+		 * @param buf   Target buffer.
+		 * @param size  Size of the target buffer.
+		 *
+		 * @returns The length of the text, which was truncated if not
+		 * less than @p size.
+		 */
+		size_t disassemble(const isa32::word_t *words, size_t count, isa32::word_t base, char *buf, size_t size) const;
+};
+
+#endif /* DISASSEMBLER_H_ */
@@ -0,0 +1,195 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef PERFECTHASH_H_
+#define PERFECTHASH_H_
+
+	// Theirs
+	#include <cstddef>
+	#include <cstdint>
+	#include <stdexcept>
+	#include <string_view>
+	#include <utility>
+
+	/**
+	 * @brief Maximum number of seeds tried when building a perfect hash.
+	 */
+	#define PERFECTHASH_MAX_SEEDS 4096
+
+	/**
+	 * @brief Perfect Hash Table
+	 *
+	 * @details A read-only table from string keys to values, built at
+	 * compile time. A seed is searched for so that every key hashes to a
+	 * distinct slot, so a lookup costs one hash and one key comparison
+	 * and never allocates.
+	 *
+	 * @tparam T Type of values.
+	 * @tparam N Number of keys.
+	 */
+	template<typename T, std::size_t N>
+	class PerfectHash
+	{
+		public:
+
+			/**
+			 * @brief Number of slots (a power of two, at least 4 * N).
+			 */
+			static constexpr std::size_t SLOTS = []() {
+				std::size_t slots = 1;
+				while (slots < 4*N)
+					slots <<= 1;
+				return (slots);
+			}();
+
+			/**
+			 * @brief Marks an empty slot.
+			 */
+			static constexpr std::uint16_t EMPTY = UINT16_MAX;
+
+			static_assert(N < EMPTY, "too many keys");
+
+		private:
+
+			std::string_view keys_[N];    /**< Keys.                 */
+			T values_[N];                 /**< Values.               */
+			std::uint16_t slots_[SLOTS];  /**< Slot to key index.    */
+			std::uint32_t seed_;          /**< Seed of the hash.     */
+
+		public:
+
+			/**
+			 * @brief Hashes a key with seeded 32-bit FNV-1a.
+			 *
+			 * @param key  Target key.
+			 * @param seed Seed of the hash.
+			 *
+			 * @returns The hash of @p key.
+			 */
+			static constexpr std::uint32_t hash(std::string_view key, std::uint32_t seed)
+			{
+				std::uint32_t h = 2166136261u ^ seed;
+
+				for (char c : key)
+				{
+					h ^= static_cast<unsigned char>(c);
+					h *= 16777619u;
+				}
+
+				return (h ^ (h >> 15));
+			}
+
+			/**
+			 * @brief Builds a perfect hash table.
+			 *
+			 * @param entries Keys and values.
+			 *
+			 * @throws std::logic_error No seed separates the keys
+			 * (e.g. a duplicate key). In a constant expression, this
+			 * is a compile error.
+			 */
+			constexpr PerfectHash(const std::pair<std::string_view, T> (&entries)[N])
+				: keys_(), values_(), slots_(), seed_(0)
+			{
+				for (std::size_t i = 0; i < N; i++)
+				{
+					keys_[i] = entries[i].first;
+					values_[i] = entries[i].second;
+				}
+
+				for (seed_ = 0; seed_ < PERFECTHASH_MAX_SEEDS; seed_++)
+				{
+					if (place())
+						return;
+				}
+
+				throw std::logic_error("no perfect hash");
+			}
+
+			/**
+			 * @brief Looks up a key.
+			 *
+			 * @param key Target key.
+			 *
+			 * @returns The value of @p key, or a null pointer if
+			 * @p key is not in the table.
+			 */
+			constexpr const T *find(std::string_view key) const
+			{
+				std::uint16_t i = slots_[hash(key, seed_) & (SLOTS - 1)];
+
+				if ((i == EMPTY) || (keys_[i] != key))
+					return (nullptr);
+
+				return (&values_[i]);
+			}
+
+			/**
+			 * @brief Returns the number of keys.
+			 */
+			constexpr std::size_t size(void) const
+			{
+				return (N);
+			}
+
+		private:
+
+			/**
+			 * @brief Places every key with the current seed.
+			 *
+			 * @returns True if no two keys collide, false otherwise.
+			 */
+			constexpr bool place(void)
+			{
+				for (std::size_t s = 0; s < SLOTS; s++)
+					slots_[s] = EMPTY;
+
+				for (std::size_t i = 0; i < N; i++)
+				{
+					std::uint16_t &slot = slots_[hash(keys_[i], seed_) & (SLOTS - 1)];
+
+					if (slot != EMPTY)
+						return (false);
+
+					slot = static_cast<std::uint16_t>(i);
+				}
+
+				return (true);
+			}
+	};
+
+	/**
+	 * @brief Builds a perfect hash table, deducing its size.
+	 *
+	 * @param entries Keys and values.
+	 *
+	 * @returns The perfect hash table.
+	 */
+	template<typename T, std::size_t N>
+	constexpr PerfectHash<T, N> makePerfectHash(const std::pair<std::string_view, T> (&entries)[N])
+	{
+		return (PerfectHash<T, N>(entries));
+	}
+
+#endif /* PERFECTHASH_H_ */
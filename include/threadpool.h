@@ -0,0 +1,103 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+	// Theirs
+	#include <condition_variable>
+	#include <cstddef>
+	#include <functional>
+	#include <mutex>
+	#include <queue>
+	#include <thread>
+	#include <vector>
+
+	/**
+	 * @brief Thread Pool
+	 *
+	 * @details A fixed set of worker threads that run tasks from a shared
+	 * queue.
+	 */
+	class ThreadPool
+	{
+		private:
+
+			std::vector<std::thread> workers_;        /**< Worker threads.      */
+			std::queue<std::function<void()>> tasks_; /**< Pending tasks.       */
+			std::mutex lock_;                         /**< Guards the queue.    */
+			std::condition_variable ready_;           /**< Signals new tasks.   */
+			bool stop_;                               /**< Shutting down?       */
+
+			/**
+			 * @brief Runs tasks until the pool is shut down.
+			 */
+			void work(void);
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param threads Number of worker threads (0 for one per host CPU).
+			 */
+			ThreadPool(unsigned threads = 0);
+
+			/**
+			 * @brief Default destructor.
+			 *
+			 * @details Pending tasks are run before the workers exit.
+			 */
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool &) = delete;
+			ThreadPool &operator=(const ThreadPool &) = delete;
+
+			/**
+			 * @brief Runs a function over a range of indexes.
+			 *
+			 * @details Calls @p fn once for each index in [0, @p count)
+			 * on the workers and returns when all calls are done. The
+			 * first exception thrown by a call is rethrown. Must not be
+			 * called from within a task.
+			 *
+			 * @param count Number of indexes.
+			 * @param fn    Target function.
+			 */
+			void run(size_t count, const std::function<void(size_t)> &fn);
+
+			/**
+			 * @brief Gets the number of worker threads.
+			 */
+			unsigned size(void) const { return (workers_.size()); }
+
+			/**
+			 * @brief Gets the pool shared by the whole simulator.
+			 *
+			 * @details The pool is sized by #VMACHINE_THREADS.
+			 */
+			static ThreadPool &instance(void);
+	};
+
+#endif /* THREADPOOL_H_ */
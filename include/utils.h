@@ -25,6 +25,8 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+	#include <cstddef>
+	#include <cstdint>
 	#include <string>
 
 	/**
@@ -69,4 +71,15 @@
 	 */
 	extern void error(const std::string &msg);
 
+	/**
+	 * @brief Hashes a buffer with 64-bit FNV-1a.
+	 *
+	 * @param data Target buffer.
+	 * @param size Size of the target buffer (in bytes).
+	 * @param seed Hash to continue from.
+	 *
+	 * @returns The hash of @p data.
+	 */
+	extern uint64_t hash64(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
 #endif /* UTILS_H_ */
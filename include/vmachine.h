@@ -26,14 +26,17 @@
 #define VMACHINE_H_
 
 	// Theirs
+	#include <memory>
 	#include <string>
 	#include <iostream>
 
 	// Ours
 	#include <vmachine/cache.h>
 	#include <vmachine/core.h>
+	#include <vmachine/image.h>
 	#include <vmachine/isa.h>
 	#include <vmachine/memory.h>
+	#include <vmachine/symbols.h>
 	#include <arch.h>
 
 namespace vmachine
@@ -64,6 +67,23 @@ namespace vmachine
 			 */
 			vmachine::Core core;
 
+			/**
+			 * @brief Image in use, if shared.
+			 */
+			std::shared_ptr<SharedImage> image;
+
+			/**
+			 * @brief Symbols of the loaded program.
+			 */
+			std::shared_ptr<const SymbolIndex> symbols = std::make_shared<SymbolIndex>();
+
+			/**
+			 * @brief Reports performance statistics.
+			 *
+			 * @param outfile Output file where statistics should be written.
+			 */
+			void report(std::ostream &outfile);
+
 		public:
 
 			/**
@@ -77,27 +97,71 @@ namespace vmachine
 				icache(icache_),
 				dcache(dcache_),
 				memory(memory_),
-				core(memory_)
-			{ }
+				core(icache_, dcache_, memory_)
+			{
+				icache.attach(memory);
+				dcache.attach(memory);
+			}
 
 			/**
 			 * @brief Loads an ASM file into the virtual machine.
 			 *
+			 * @details The assembled program is cached as a native image,
+			 * keyed on the source and the assembler version, and later
+			 * loads of the same source map that image instead.
+			 *
 			 * @param asmfile Target assembly file.
 			 */
 			void load(std::string &asmfile);
 
+			/**
+			 * @brief Loads an ASM file with a given assembler.
+			 *
+			 * @details As load(std::string &), with programs cached
+			 * apart for each assembler.
+			 *
+			 * @param asmfile   Target assembly file.
+			 * @param assembler Assembler for the language of @p asmfile.
+			 */
+			void load(std::string &asmfile, const Assembler &assembler);
+
 			/**
 			 * @brief Starts the virtual machine.
 			 */
 			void start(void);
 
-			/*
-			 * @brief Loads a binary file into the virtual machine.
+			/**
+			 * @brief Loads an ELF32 executable into the virtual machine.
+			 *
+			 * @details Loadable segments are mapped at their virtual
+			 * addresses, .bss is zero-filled on demand and the program
+			 * counter is set to the entry point. Unless @p eager is set,
+			 * contents that cannot be mapped are read on first access.
 			 *
 			 * @param binFile Target a binary file.
+			 * @param eager   Read all contents in upfront, in parallel?
+			 */
+			void loadFile(std::string &binFile, bool eager = false);
+
+			/**
+			 * @brief Loads a native image into the virtual machine.
+			 *
+			 * @details Segments are mapped as laid out in the image, with
+			 * no further parsing.
+			 *
+			 * @param imgFile Target image file.
+			 */
+			void loadImage(std::string &imgFile);
+
+			/**
+			 * @brief Maps a shared image into the virtual machine.
+			 *
+			 * @details Text and data are shared with every other machine
+			 * that maps @p img, until written.
+			 *
+			 * @param img Target image.
 			 */
-			void loadFile(std::string &binFile);
+			void load(const std::shared_ptr<SharedImage> &img);
 
 			/**
 			 * @brief Executes a single instruction.
@@ -106,6 +170,11 @@ namespace vmachine
 			 */
 			void execute(isa32::word_t inst) { core.execute(inst); }
 
+			/**
+			 * @brief Fetches and executes the instruction at the program counter.
+			 */
+			void step(void) { core.step(); }
+
 			/**
 			 * @brief Gets the value the program counter register.
 			 */
@@ -118,6 +187,21 @@ namespace vmachine
 			 */
 			isa32::word_t getRegister(unsigned regnum) { return (core.getRegister(regnum)); }
 
+			/**
+			 * @brief Gets the symbols of the loaded program.
+			 */
+			const SymbolIndex &getSymbols(void) const { return (*symbols); }
+
+			/**
+			 * @brief Gets the number of elapsed cycles.
+			 */
+			uint64_t getCycles(void) { return (core.getCycles()); }
+
+			/**
+			 * @brief Gets the number of retired instructions.
+			 */
+			uint64_t getInstructions(void) { return (core.getInstructions()); }
+
 			/**
 			 * @brief Shutdowns the target virtual machine.
 			 *
@@ -25,11 +25,67 @@
 #ifndef CACHE_H_
 #define CACHE_H_
 
+	// Theirs
+	#include <cstdint>
+
+	// Ours
+	#include <vmachine/coherence.h>
+	#include <vmachine/memory.h>
+	#include <vmachine/prefetcher.h>
+	#include <arch.h>
+	#include <config.h>
+
 	/**
 	 *  @brief Cache
+	 *
+	 *  @details The cache models tags only: data always lives in the
+	 *  attached main memory. Tags of a set are laid out contiguously, so
+	 *  that a whole set can be matched with a few vector compares.
 	 */
 	class Cache
 	{
+		friend class Directory;
+
+		public:
+
+			/**
+			 * @brief Maximum Associativity
+			 */
+			static const unsigned MAX_WAYS = 32;
+
+			/**
+			 * @brief Implementations of Tag Lookup
+			 */
+			enum LookupImpl
+			{
+				LOOKUP_SCALAR, /**< Portable loop over the ways. */
+				LOOKUP_SSE2,   /**< 4 tags per compare.          */
+				LOOKUP_AVX2    /**< 8 tags per compare.          */
+			};
+
+		private:
+
+			/**
+			 * @brief Tag lookup function.
+			 *
+			 * @param tags  Tags of the target set.
+			 * @param ways  Number of tags to match (multiple of 8).
+			 * @param tag   Target tag.
+			 *
+			 * @returns A bitmap with the ways whose tag matches @p tag.
+			 */
+			typedef unsigned (*lookup_fn)(const isa32::word_t *tags, unsigned ways, isa32::word_t tag);
+
+			/**
+			 * @brief Tag lookup function selected at startup.
+			 */
+			static lookup_fn lookup_;
+
+			/**
+			 * @brief Selects the fastest tag lookup supported by the host.
+			 */
+			static lookup_fn select(void);
+
 		protected:
 
 			/**
@@ -38,55 +94,401 @@
 			unsigned size_;
 
 			/**
-			 * @brief Underlying Data
+			 * @brief Geometry
+			 */
+			/**@{*/
+			unsigned ways_;       /**< Associativity                 */
+			unsigned lineSize_;   /**< Line size (in bytes)          */
+			unsigned sets_;       /**< Number of sets                */
+			unsigned stride_;     /**< Tags per set, padded          */
+			unsigned lineShift_;  /**< log2(lineSize_)               */
+			/**@}*/
+
+			/**
+			 * @brief Hit Latency (in cycles)
+			 */
+			unsigned latency_;
+
+			/**
+			 * @brief Tags
+			 */
+			isa32::word_t *tags;
+
+			/**
+			 * @brief Bitmap of valid ways in each set.
+			 */
+			uint32_t *valid;
+
+			/**
+			 * @brief Bitmap of prefetched ways not yet hit, in each set.
+			 */
+			uint32_t *prefetched;
+
+			/**
+			 * @brief Bitmap of ways invalidated by coherence, in each set.
+			 */
+			uint32_t *invalidated;
+
+			/**
+			 * @brief MESI state of each line.
+			 */
+			uint8_t *states;
+
+			/**
+			 * @brief Last-use stamps for LRU replacement.
+			 */
+			uint32_t *stamps;
+
+			/**
+			 * @brief Current LRU stamp.
+			 */
+			uint32_t clock_;
+
+			/**
+			 * @brief Backing memory.
+			 */
+			Memory *memory_;
+
+			/**
+			 * @brief Next cache level.
+			 */
+			Cache *next_;
+
+			/**
+			 * @brief Coherence
+			 */
+			/**@{*/
+			Directory *directory_; /**< Coherence directory.         */
+			unsigned id_;          /**< Identifier in the directory. */
+			/**@}*/
+
+			/**
+			 * @brief Prefetching
+			 */
+			/**@{*/
+			Prefetcher *prefetcher_;  /**< Attached prefetcher.                */
+			PrefetchQueue queue_;     /**< Pending prefetches.                 */
+			isa32::word_t *victims;   /**< Demand lines evicted by prefetches. */
+			PrefetchStats prefetchStats_;
+			/**@}*/
+
+			/**
+			 * @brief Statistics
+			 */
+			/**@{*/
+			uint64_t hits_;   /**< Number of hits.   */
+			uint64_t misses_; /**< Number of misses. */
+			uint64_t drops_;  /**< Number of dropped lines. */
+			/**@}*/
+
+			/**
+			 * @brief Matches a line against the tags of a set.
+			 *
+			 * @param set  Target set.
+			 * @param line Target line address.
+			 *
+			 * @returns A bitmap with the ways whose tag matches, valid or not.
+			 */
+			unsigned match(unsigned set, isa32::word_t line) const
+			{
+				return (lookup_(&tags[set*stride_], stride_, line));
+			}
+
+			/**
+			 * @brief Looks up the way that holds a line.
+			 *
+			 * @param set  Target set.
+			 * @param line Target line address.
+			 *
+			 * @returns The matching way, or -1 on miss.
+			 */
+			int lookup(unsigned set, isa32::word_t line) const;
+
+			/**
+			 * @brief Drops the line held in a way.
+			 *
+			 * @param set Target set.
+			 * @param way Target way.
+			 */
+			void drop(unsigned set, unsigned way);
+
+			/**
+			 * @brief Invalidates a line on behalf of the directory.
+			 *
+			 * @param line Target line address.
+			 *
+			 * @returns The state of the line before invalidation.
+			 */
+			MesiState snoopInvalidate(isa32::word_t line);
+
+			/**
+			 * @brief Downgrades a line to shared on behalf of the directory.
+			 *
+			 * @param line Target line address.
+			 *
+			 * @returns The state of the line before the downgrade.
+			 */
+			MesiState snoopDowngrade(isa32::word_t line);
+
+			/**
+			 * @brief Fills a line in a set, evicting the LRU way.
+			 *
+			 * @param set      Target set.
+			 * @param line     Target line address.
+			 * @param prefetch Is this a prefetch fill?
+			 *
+			 * @returns The way where the line was placed.
+			 */
+			unsigned fill(unsigned set, isa32::word_t line, bool prefetch);
+
+			/**
+			 * @brief Issues pending prefetches.
+			 */
+			void prefetch(void);
+
+			/**
+			 * @brief Fills a line on behalf of a prefetch from the previous level.
+			 *
+			 * @details Unlike a demand access, this neither counts as a
+			 * hit or miss nor trains the attached prefetcher.
+			 *
+			 * @param addr Target address.
 			 */
-			unsigned *data;
+			void prefetchFill(unsigned addr);
 
 		public:
 
 			/**
 			 * @brief Default constructor.
 			 *
-			 * @param size Size of cache memory (in bytes).
+			 * @param size     Size of cache memory (in bytes).
+			 * @param ways     Associativity.
+			 * @param lineSize Size of a cache line (in bytes).
 			 */
-			Cache(unsigned size);
+			Cache(
+				unsigned size,
+				unsigned ways = VMACHINE_DEFAULT_CACHE_WAYS,
+				unsigned lineSize = VMACHINE_DEFAULT_CACHE_LINE_SIZE
+			);
 
 			/**
 			 * @brief Default destructor.
 			 */
 			~Cache();
 
+			Cache(const Cache &) = delete;
+			Cache &operator=(const Cache &) = delete;
+
 			/**
-			 * @brief Reads a word from the target memory.
+			 * @brief Attaches the backing memory of the cache.
+			 *
+			 * @param memory Target memory.
+			 */
+			void attach(Memory &memory) { memory_ = &memory; }
+
+			/**
+			 * @brief Attaches the next cache level.
+			 *
+			 * @param next Target cache.
+			 */
+			void attach(Cache &next) { next_ = &next; }
+
+			/**
+			 * @brief Attaches a hardware prefetcher.
+			 *
+			 * @param prefetcher Target prefetcher.
+			 */
+			void attach(Prefetcher &prefetcher);
+
+			/**
+			 * @brief Attaches the cache to a coherence directory.
+			 *
+			 * @param directory Target directory.
+			 */
+			void attach(Directory &directory);
+
+			/**
+			 * @brief Accesses a line, filling it on a miss.
+			 *
+			 * @param addr    Target address.
+			 * @param pc      Program counter of the access.
+			 * @param write   Is this a write access?
+			 * @param latency Where to store the latency of the access (optional).
+			 *
+			 * @returns True on hit, false otherwise.
+			 */
+			bool access(unsigned addr, isa32::word_t pc = 0, bool write = false, unsigned *latency = nullptr);
+
+			/**
+			 * @brief Gets the MESI state of a line.
 			 *
 			 * @param addr Target address.
+			 */
+			MesiState getState(unsigned addr) const;
+
+			/**
+			 * @brief Checks if a line is present, without side effects.
+			 *
+			 * @param addr Target address.
+			 *
+			 * @returns True if the line is present, false otherwise.
+			 */
+			bool probe(unsigned addr) const;
+
+			/**
+			 * @brief Invalidates a line.
+			 *
+			 * @param addr Target address.
+			 */
+			void invalidate(unsigned addr);
+
+			/**
+			 * @brief Invalidates all lines.
+			 */
+			void flush(void);
+
+			/**
+			 * @brief Reads a word from the target memory.
+			 *
+			 * @param addr    Target address.
+			 * @param pc      Program counter of the access.
+			 * @param latency Where to store the latency of the access (optional).
 			 *
 			 * @returns The requested word.
 			 *
 			 * @todo Use custom types.
 			 */
-			unsigned read(unsigned addr);
+			unsigned read(unsigned addr, isa32::word_t pc = 0, unsigned *latency = nullptr);
+
+			/**
+			 * @brief Sets the hit latency.
+			 *
+			 * @param latency Hit latency (in cycles).
+			 */
+			void setLatency(unsigned latency) { latency_ = latency; }
+
+			/**
+			 * @brief Gets the hit latency (in cycles).
+			 */
+			unsigned getLatency(void) const { return (latency_); }
+
+			/**
+			 * @brief Gets the number of hits.
+			 */
+			uint64_t getHits(void) const { return (hits_); }
+
+			/**
+			 * @brief Gets the number of misses.
+			 */
+			uint64_t getMisses(void) const { return (misses_); }
+
+			/**
+			 * @brief Gets prefetch statistics.
+			 */
+			const PrefetchStats &getPrefetchStats(void) const { return (prefetchStats_); }
+
+			/**
+			 * @brief Gets the fraction of issued prefetches that were useful.
+			 */
+			double getPrefetchAccuracy(void) const;
+
+			/**
+			 * @brief Gets the fraction of would-be misses removed by prefetching.
+			 */
+			double getPrefetchCoverage(void) const;
+
+			/**
+			 * @brief Gets the associativity.
+			 */
+			unsigned getWays(void) const { return (ways_); }
+
+			/**
+			 * @brief Gets the number of sets.
+			 */
+			unsigned getSets(void) const { return (sets_); }
+
+			/**
+			 * @brief Gets the size of a cache line (in bytes).
+			 */
+			unsigned getLineSize(void) const { return (lineSize_); }
+
+			/**
+			 * @brief Forces an implementation of tag lookup.
+			 *
+			 * @param impl Target implementation.
+			 *
+			 * @returns True if the host supports @p impl, false otherwise.
+			 */
+			static bool setLookupImpl(LookupImpl impl);
+
+			/**
+			 * @brief Gets the implementation of tag lookup in use.
+			 */
+			static LookupImpl getLookupImpl(void);
 	};
 
 	/**
 	 *  @brief Instruction Cache
 	 */
-	class ICache : Cache
+	class ICache : public Cache
 	{
+		private:
+
+			/**
+			 * @brief Fetch Buffer
+			 *
+			 * @details Remembers the last fetched line, so that sequential
+			 * fetches within it skip the tag lookup. A buffer hit costs 0
+			 * cycles and refreshes the LRU stamp of the line through the
+			 * buffered way. Words are still read from memory, so stores
+			 * and remaps are always seen. The buffer is dropped whenever
+			 * the cache drops any line.
+			 */
+			/**@{*/
+			isa32::word_t bufferLine_;  /**< Address of the buffered line.         */
+			unsigned bufferSlot_;       /**< Stamp of the buffered way.            */
+			uint64_t bufferDrops_;      /**< Dropped lines when the buffer filled. */
+			bool bufferValid_;          /**< Does the buffer hold a line?          */
+			uint64_t bufferHits_;       /**< Fetches served by the buffer.         */
+			/**@}*/
+
 		public:
 
 			/**
 			 * @brief Default constructor.
 			 *
-			 * @param size Size of cache memory (in bytes).
+			 * @param size     Size of cache memory (in bytes).
+			 * @param ways     Associativity.
+			 * @param lineSize Size of a cache line (in bytes).
+			 */
+			ICache(
+				unsigned size,
+				unsigned ways = VMACHINE_DEFAULT_CACHE_WAYS,
+				unsigned lineSize = VMACHINE_DEFAULT_CACHE_LINE_SIZE
+			);
+
+			/**
+			 * @brief Fetches an instruction.
+			 *
+			 * @details Fetches served by the fetch buffer take 0 cycles.
+			 *
+			 * @param addr    Target address.
+			 * @param latency Where to store the latency of the fetch (optional).
+			 *
+			 * @returns The fetched instruction.
+			 */
+			isa32::word_t fetch(unsigned addr, unsigned *latency = nullptr);
+
+			/**
+			 * @brief Gets the number of fetches served by the fetch buffer.
 			 */
-			ICache(unsigned size) : Cache(size) {}
+			uint64_t getBufferHits(void) const { return (bufferHits_); }
 	};
 
 	/**
 	 *  @brief Data Cache
 	 */
-	class DCache : Cache
+	class DCache : public Cache
 	{
 		public:
 
@@ -100,12 +502,14 @@
 			/**
 			 * @brief Writes a word to the target memory.
 			 *
-			 * @param addr Target address.
-			 * @param word Word.
+			 * @param addr    Target address.
+			 * @param word    Word.
+			 * @param pc      Program counter of the access.
+			 * @param latency Where to store the latency of the access (optional).
 			 *
 			 * @todo Use custom types.
 			 */
-			void write(unsigned addr, unsigned word);
+			void write(unsigned addr, unsigned word, isa32::word_t pc = 0, unsigned *latency = nullptr);
 	};
 
-#endif // CACHE_H_
\ No newline at end of file
+#endif // CACHE_H_
@@ -0,0 +1,183 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef VMACHINE_COHERENCE_H_
+#define VMACHINE_COHERENCE_H_
+
+	// Theirs
+	#include <cstdint>
+	#include <unordered_map>
+
+	// Ours
+	#include <arch.h>
+
+	// Forward definitions.
+	class Cache;
+
+	/**
+	 * @brief MESI States
+	 */
+	enum MesiState
+	{
+		MESI_INVALID,   /**< Not present.                      */
+		MESI_SHARED,    /**< Clean, may be present elsewhere.  */
+		MESI_EXCLUSIVE, /**< Clean, present only here.         */
+		MESI_MODIFIED   /**< Dirty, present only here.         */
+	};
+
+	/**
+	 * @brief Coherence Statistics
+	 */
+	struct CoherenceStats
+	{
+		uint64_t invalidations;   /**< Lines invalidated in other caches.      */
+		uint64_t upgrades;        /**< Shared lines upgraded for a write.      */
+		uint64_t coherenceMisses; /**< Misses on lines lost to invalidations.  */
+		uint64_t interventions;   /**< Owners downgraded by a remote read.     */
+		uint64_t writebacks;      /**< Modified lines evicted or downgraded.   */
+	};
+
+	/**
+	 * @brief Coherence Directory
+	 *
+	 * @details Snoop filter at the shared level that keeps private caches
+	 * coherent with the MESI protocol. It tracks the sharers of every line
+	 * cached anywhere, so each request costs one hash lookup plus one
+	 * message per actual sharer, regardless of how many caches exist.
+	 */
+	class Directory
+	{
+		public:
+
+			/**
+			 * @brief Maximum number of attached caches.
+			 */
+			static const unsigned MAX_CACHES = 32;
+
+		private:
+
+			/**
+			 * @brief Directory entry.
+			 */
+			struct Entry
+			{
+				uint32_t sharers; /**< Bitmap of caches holding the line.  */
+				int owner;        /**< Cache holding it in E/M, or -1.     */
+			};
+
+			/**
+			 * @brief Entries of lines cached somewhere.
+			 */
+			std::unordered_map<isa32::word_t, Entry> entries;
+
+			/**
+			 * @brief Attached caches.
+			 */
+			Cache *caches[MAX_CACHES];
+
+			/**
+			 * @brief Number of attached caches.
+			 */
+			unsigned ncaches;
+
+			/**
+			 * @brief Line size of attached caches (in bytes).
+			 */
+			unsigned lineSize_;
+
+			/**
+			 * @brief Statistics.
+			 */
+			CoherenceStats stats_;
+
+			/**
+			 * @brief Invalidates a line in all sharers but one.
+			 *
+			 * @param e    Target entry.
+			 * @param line Target line address.
+			 * @param id   Cache that keeps the line.
+			 */
+			void invalidateOthers(Entry &e, isa32::word_t line, unsigned id);
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 */
+			Directory();
+
+			/**
+			 * @brief Attaches a private cache.
+			 *
+			 * @param cache Target cache.
+			 *
+			 * @returns The identifier of the cache in the directory.
+			 */
+			unsigned attach(Cache &cache);
+
+			/**
+			 * @brief Handles a read miss.
+			 *
+			 * @param id   Requesting cache.
+			 * @param line Target line address.
+			 *
+			 * @returns The state in which the line should be filled.
+			 */
+			MesiState read(unsigned id, isa32::word_t line);
+
+			/**
+			 * @brief Handles a write miss or an upgrade.
+			 *
+			 * @param id      Requesting cache.
+			 * @param line    Target line address.
+			 * @param upgrade Does the requester hold the line shared?
+			 */
+			void write(unsigned id, isa32::word_t line, bool upgrade);
+
+			/**
+			 * @brief Handles the eviction of a line.
+			 *
+			 * @param id    Evicting cache.
+			 * @param line  Target line address.
+			 * @param state State of the evicted line.
+			 */
+			void evict(unsigned id, isa32::word_t line, MesiState state);
+
+			/**
+			 * @brief Records a coherence miss.
+			 */
+			void coherenceMiss(void) { stats_.coherenceMisses++; }
+
+			/**
+			 * @brief Gets the number of lines tracked.
+			 */
+			size_t getLines(void) const { return (entries.size()); }
+
+			/**
+			 * @brief Gets coherence statistics.
+			 */
+			const CoherenceStats &getStats(void) const { return (stats_); }
+	};
+
+#endif // VMACHINE_COHERENCE_H_
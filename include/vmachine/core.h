@@ -25,8 +25,10 @@
 #ifndef VMACHINE_CORE_H_
 #define VMACHINE_CORE_H_
 
+    #include <vmachine/cache.h>
     #include <vmachine/memory.h>
     #include <arch.h>
+    #include <config.h>
 
 namespace vmachine
 {
@@ -39,6 +41,10 @@ namespace vmachine
     {
         private:
 
+            ICache &icache_;
+
+            DCache &dcache_;
+
             Memory &memory_;
 
             typedef void (Core::*execute_fn)(isa32::word_t);
@@ -53,6 +59,15 @@ namespace vmachine
              */
             isa32::word_t registers[REGISTERS_NUMS] = { 0 };
 
+            /**
+             * @brief Timing
+             */
+            /**@{*/
+            unsigned latency_ = VMACHINE_DEFAULT_CORE_LATENCY; /**< Base latency of an instruction. */
+            uint64_t cycles_ = 0;                              /**< Elapsed cycles.                 */
+            uint64_t instret_ = 0;                             /**< Retired instructions.           */
+            /**@}*/
+
             /**
              * @brief Mult/Div Registers
              */
@@ -121,14 +136,27 @@ namespace vmachine
 
             /**
              * @brief Default constructor.
+             *
+             * @param icache Private instruction cache.
+             * @param dcache Private data cache.
+             * @param memory Main memory.
              */
-            Core(Memory &memory) : memory_(memory) { }
+            Core(ICache &icache, DCache &dcache, Memory &memory) :
+                icache_(icache),
+                dcache_(dcache),
+                memory_(memory)
+            { }
 
             /**
              * @brief Runs the target core.
              */
             void run(void);
 
+            /**
+             * @brief Fetches and executes the next instruction.
+             */
+            void step(void);
+
             /**
              * @brief Executes a single instruction.
              */
@@ -139,12 +167,36 @@ namespace vmachine
 			 */
 			isa32::word_t getPC(void) { return (pc); }
 
+			/**
+			 * @brief Sets the value of the program counter register.
+			 *
+			 * @param addr Target address.
+			 */
+			void setPC(isa32::word_t addr) { pc = addr; }
+
 			/**
 			 * @brief Gets the value of a register.
 			 *
 			 * @param regnum Number of the target register.
 			 */
 			isa32::word_t getRegister(unsigned regnum) { return (registers[regnum]); }
+
+			/**
+			 * @brief Sets the base latency of an instruction.
+			 *
+			 * @param latency Base latency (in cycles).
+			 */
+			void setLatency(unsigned latency) { latency_ = latency; }
+
+			/**
+			 * @brief Gets the number of elapsed cycles.
+			 */
+			uint64_t getCycles(void) const { return (cycles_); }
+
+			/**
+			 * @brief Gets the number of retired instructions.
+			 */
+			uint64_t getInstructions(void) const { return (instret_); }
     };
 }
 
@@ -5,51 +5,73 @@
 
 #include <arch/r_format.h>
 #include <arch/instruction.h>
+#include <cstddef>
+#include <stdexcept>
 #include <string>
 
 using namespace std;
 
-class Engine
+/**
+ * Maximum number of RV32 words emitted for one MIPS32 instruction.
+ */
+#define ENGINE_MAX_WORDS 9
+
+/**
+ * State of one translation. Each call to Engine::translate()
+ * starts from a fresh Translation, so an Engine has no mutable
+ * state and may be shared by several threads.
+ */
+struct Translation
 {
-    private:
-        Rformat mips32_r_instruction;
+    Rformat mips32_r_instruction;
 
-        // Final Risc-V instruction
-        isa32::word_t rv_instruction;
+    // Final Risc-V instruction
+    isa32::word_t rv_instruction = 0;
 
-        isa32::word_t instructions_set[5];
+    isa32::word_t instructions_set[5] = {};
 
-        isa32::word_t use_register;
+    isa32::word_t use_register = 0;
 
-        isa32::word_t rv_instructionAddi;
+    isa32::word_t rv_instructionAddi = 0;
 
-        isa32::word_t rv_instructionAdd;
+    isa32::word_t rv_instructionAdd = 0;
 
-        bool flag_use_t4 = false, flag_use_t5 = false, flag_use_t4_t5 = false;
+    bool flag_use_t4 = false, flag_use_t5 = false, flag_use_t4_t5 = false;
 
-        // Translation atributtes
-        isa32::word_t S_opcode;
-        isa32::word_t Sum_funct7;
-        isa32::word_t Sum_funct3;
-        isa32::word_t Sub_funct7;
-        isa32::word_t Sub_funct3;
-        isa32::word_t Div_funct7;
-        isa32::word_t Div_funct3;
-        isa32::word_t Mult_funct7;
-        isa32::word_t Mult_funct3;
-        isa32::word_t Logic_funct7;
-        isa32::word_t Logic_funct3;
-        isa32::word_t ConJump_funct7;
-        isa32::word_t ConJump_funct3;
-        isa32::word_t Shift_funct7;
-        isa32::word_t Shift_funct3;
-        isa32::word_t UncJump_funct3;
-        isa32::word_t Format_rs;
-        isa32::word_t C_rd;
-        isa32::word_t B_rt;
-        isa32::word_t D_sa;
+    // Translation atributtes
+    isa32::word_t S_opcode = 0;
+    isa32::word_t Format_rs = 0;
+    isa32::word_t C_rd = 0;
+    isa32::word_t B_rt = 0;
+    isa32::word_t D_sa = 0;
+};
 
+/**
+ * RV32 words emitted for one MIPS32 instruction. The
+ * words are stored inline, so no allocation is needed.
+ */
+struct TranslationBuffer
+{
+    isa32::word_t words[ENGINE_MAX_WORDS] = {};
+
+    size_t count = 0;
+
+    /**
+     * Append a word to the buffer.
+     * @param word RV32 instruction
+     * @throws std::length_error The buffer is full.
+     */
+    void push(isa32::word_t word)
+    {
+        if (count >= ENGINE_MAX_WORDS)
+            throw std::length_error("translation buffer is full");
+
+        words[count++] = word;
+    }
+};
 
+class Engine
+{
     public:
 
         /**
@@ -57,113 +79,122 @@ class Engine
          * @param tk1
          * @param tk2
          * */
-        void match(isa32::word_t token1,isa32::word_t token2);
+        void match(isa32::word_t token1,isa32::word_t token2) const;
 
         /*
         * r_procedure_D();
         */
-        void r_procedure_D();
+        void r_procedure_D(Translation &t) const;
 
         /*
         * r_procedure_C();
         */
-        void r_procedure_C();
+        void r_procedure_C(Translation &t) const;
 
         /*
         * r_procedure_B();
         */
-        void r_procedure_B();
+        void r_procedure_B(Translation &t) const;
 
         /*
         * r_procefure_Format()
         */
-        void r_procedure_Format();
+        void r_procedure_Format(Translation &t) const;
 
         /**
          * r_pocedure_Sum();
          */
-        void r_procedure_Sum();
+        void r_procedure_Sum(Translation &t) const;
 
         /**
          * r_pocedure_Sub();
          */
-        void r_procedure_Sub();
+        void r_procedure_Sub(Translation &t) const;
 
         /**
          * r_pocedure_Div();
          */
-        void r_procedure_Div();
+        void r_procedure_Div(Translation &t) const;
 
         /**
          * r_pocedure_Mult();
          */
-        void r_procedure_Mult();
+        void r_procedure_Mult(Translation &t) const;
 
         /**
          * r_pocedure_Arithmetic();
          */
-        void r_procedure_Arithmetic();
+        void r_procedure_Arithmetic(Translation &t) const;
 
         /**
          * r_procedure_ConJump();
          */
-        void r_procedure_ConJump();
+        void r_procedure_ConJump(Translation &t) const;
 
         /**
          * r_procedure_Shift();
          */
-        void r_procedure_Shift();
+        void r_procedure_Shift(Translation &t) const;
 
         /**
          * r_procedure_UncJump();
          */
-        void r_procedure_UncJump();
+        void r_procedure_UncJump(Translation &t) const;
 
         /**
          * r_procedure_Logic();
          */
-        void r_procedure_Logic();
+        void r_procedure_Logic(Translation &t) const;
 
         /**
          * r_pocedure_Function();
          */
-        void r_procedure_Function();
+        void r_procedure_Function(Translation &t) const;
 
         /*
         * First rule of grammar and Parsing tree
         */
-        void r_procedure_S();
+        void r_procedure_S(Translation &t) const;
 
         /**
          * Translate binary code MIPS32 in RV32.
          * Opening process of translate
          */
-        void r_translator();
+        void r_translator(Translation &t) const;
 
         /**
          * Make the management of the special
          * registers in MIPS32 $t4 and $t5
          */
-        void register_management();
+        void register_management(Translation &t) const;
 
         /**
          * Select type of instruction.
          * Extract each word of instruction
          * and redirects for each function corresponding
+         * @param t    Target translation
          * @param inst MIPS instruction of 32 bits
          */
-        void selectInstruction(isa32::word_t word_inst);
+        void selectInstruction(Translation &t, isa32::word_t word_inst) const;
 
         /*
          * Make merge in the instructions to a instructions buffer.
         */
-        isa32::word_t *getBuffer();
+        TranslationBuffer getBuffer(Translation &t) const;
+
+        /**
+         * Translate a MIPS32 instruction.
+         * @param instruction MIPS instruction of 32 bits
+         * @returns The state of the translation.
+         */
+        Translation translate(isa32::word_t instruction) const;
 
         /**
          * The engine_run() function translates a binary code into another.
+         * @returns The first RV32 word of the translation.
          */
-        isa32::word_t engine_run(uint32_t instruction);
+        isa32::word_t engine_run(uint32_t instruction) const;
 
 };
 
-#endif /* UTILS_H_ */
\ No newline at end of file
+#endif /* VMACHINE_ENGINE_H_ */
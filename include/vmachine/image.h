@@ -0,0 +1,290 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef VMACHINE_IMAGE_H_
+#define VMACHINE_IMAGE_H_
+
+	// Theirs
+	#include <elf.h>
+	#include <iostream>
+	#include <memory>
+	#include <string>
+	#include <vector>
+
+	// Ours
+	#include <vmachine/symbols.h>
+	#include <assembler.h>
+	#include <arch.h>
+
+namespace vmachine
+{
+	/**
+	 * @brief Native Image Format
+	 *
+	 * @details A native image starts with an #ImageHeader, followed by a
+	 * table of #ImageSegment, a table of #ImageSymbol and a string table.
+	 * Segment contents come last, each placed at a file offset congruent
+	 * to its address modulo #VMIMG_ALIGN, so that they can be mapped
+	 * straight into guest memory.
+	 */
+	/**@{*/
+	#define VMIMG_MAGIC   0x474d4956 /**< "VIMG"                  */
+	#define VMIMG_VERSION 2          /**< Version of the format.  */
+	#define VMIMG_ALIGN   4096       /**< Alignment of contents.  */
+	/**@}*/
+
+	/**
+	 * @brief Image Header
+	 */
+	struct ImageHeader
+	{
+		uint32_t magic;     /**< #VMIMG_MAGIC                   */
+		uint32_t version;   /**< #VMIMG_VERSION                 */
+		uint32_t entry;     /**< Entry point.                   */
+		uint32_t segoff;    /**< File offset of segment table.  */
+		uint32_t nsegments; /**< Number of segments.            */
+		uint32_t symoff;    /**< File offset of symbol table.   */
+		uint32_t nsymbols;  /**< Number of symbols.             */
+		uint32_t stroff;    /**< File offset of string table.   */
+		uint32_t strsize;   /**< Size of string table.          */
+	};
+
+	/**
+	 * @brief Image Segment
+	 */
+	struct ImageSegment
+	{
+		uint32_t offset; /**< File offset of contents.  */
+		uint32_t vaddr;  /**< Guest address.            */
+		uint32_t filesz; /**< Size of contents.         */
+		uint32_t memsz;  /**< Size in memory.           */
+	};
+
+	/**
+	 * @brief Image Symbol
+	 */
+	struct ImageSymbol
+	{
+		uint32_t name;  /**< Offset of name in string table. */
+		uint32_t value; /**< Address.                        */
+		uint32_t size;  /**< Size (zero if unknown).         */
+	};
+
+	/**
+	 * @brief Program Image
+	 *
+	 * @details In-memory form of a program, used to build native images.
+	 */
+	class Image
+	{
+		public:
+
+			/**
+			 * @brief Loadable Segment
+			 */
+			struct Segment
+			{
+				isa32::word_t vaddr;    /**< Guest address.   */
+				isa32::word_t memsz;    /**< Size in memory.  */
+				std::vector<char> data; /**< File contents.   */
+			};
+
+			/**
+			 * @brief Symbol
+			 */
+			struct Symbol
+			{
+				std::string name;    /**< Name.                    */
+				isa32::word_t value; /**< Address.                 */
+				isa32::word_t size;  /**< Size (zero if unknown).  */
+			};
+
+			isa32::word_t entry = 0;       /**< Entry point. */
+			std::vector<Segment> segments; /**< Segments.    */
+			std::vector<Symbol> symbols;   /**< Symbols.     */
+
+			/**
+			 * @brief Builds an image from an ELF32 executable.
+			 *
+			 * @param path Path to the executable.
+			 */
+			static Image fromElf(const std::string &path);
+
+			/**
+			 * @brief Builds an image from an ELF32 executable.
+			 *
+			 * @param fd File descriptor of the executable.
+			 */
+			static Image fromElf(int fd);
+
+			/**
+			 * @brief Builds an image from an assembly file.
+			 *
+			 * @param path Path to the assembly file.
+			 */
+			static Image fromAsm(const std::string &path);
+
+			/**
+			 * @brief Builds an image from assembly source.
+			 *
+			 * @param input Assembly source.
+			 * @param base  Address of the first instruction.
+			 */
+			static Image fromAsm(std::istream &input, isa32::word_t base = 0);
+
+			/**
+			 * @brief Builds an image from assembly source.
+			 *
+			 * @param input     Assembly source.
+			 * @param base      Address of the first instruction.
+			 * @param assembler Assembler for the language of @p input.
+			 */
+			static Image fromAsm(std::istream &input, isa32::word_t base, const Assembler &assembler);
+
+			/**
+			 * @brief Builds an image from an assembled program.
+			 *
+			 * @param prog Target program.
+			 */
+			static Image fromProgram(const Program &prog);
+
+			/**
+			 * @brief Writes the image in native format.
+			 *
+			 * @param path Path to the output file.
+			 */
+			void write(const std::string &path) const;
+
+			/**
+			 * @brief Writes the image in native format.
+			 *
+			 * @param fd Output file descriptor.
+			 */
+			void write(int fd) const;
+
+			/**
+			 * @brief Writes the image as an ELF32 executable.
+			 *
+			 * @details Each segment becomes a PT_LOAD segment whose
+			 * contents keep the page offset of their address, so that
+			 * they can be mapped straight into guest memory. Symbols
+			 * go in a symbol table.
+			 *
+			 * @param path Path to the output file.
+			 */
+			void writeElf(const std::string &path) const;
+
+			/**
+			 * @brief Writes the image as an ELF32 executable.
+			 *
+			 * @param fd Output file descriptor.
+			 */
+			void writeElf(int fd) const;
+	};
+
+	/**
+	 * @brief Shared Read-Only Image
+	 *
+	 * @details A native image opened once and mapped by any number of
+	 * virtual machines. Mappings are private, so guest writes copy the
+	 * touched page and never reach other machines. Opening a file that
+	 * is already in use returns the same image.
+	 */
+	class SharedImage
+	{
+		private:
+
+			int fd_;                                       /**< Native image.  */
+			isa32::word_t entry_;                          /**< Entry point.   */
+			std::vector<ImageSegment> segments_;           /**< Segments.      */
+			std::shared_ptr<const SymbolIndex> symbols_;   /**< Symbols.       */
+
+			/**
+			 * @brief Creates a shared image.
+			 *
+			 * @param fd File descriptor of a native image, owned from now on.
+			 */
+			SharedImage(int fd);
+
+		public:
+
+			/**
+			 * @brief Default destructor.
+			 */
+			~SharedImage();
+
+			SharedImage(const SharedImage &) = delete;
+			SharedImage &operator=(const SharedImage &) = delete;
+
+			/**
+			 * @brief Opens a shared image.
+			 *
+			 * @details ELF32 executables are converted into a native image
+			 * in anonymous memory, once for all machines.
+			 *
+			 * @param path Path to a native image or an ELF32 executable.
+			 */
+			static std::shared_ptr<SharedImage> open(const std::string &path);
+
+			/**
+			 * @brief Gets the file descriptor of the native image.
+			 */
+			int getFd(void) const { return (fd_); }
+
+			/**
+			 * @brief Gets the entry point.
+			 */
+			isa32::word_t getEntry(void) const { return (entry_); }
+
+			/**
+			 * @brief Gets the segments.
+			 */
+			const std::vector<ImageSegment> &getSegments(void) const { return (segments_); }
+
+			/**
+			 * @brief Gets the symbols.
+			 */
+			std::shared_ptr<const SymbolIndex> getSymbols(void) const { return (symbols_); }
+	};
+
+	/**
+	 * @brief Asserts that an ELF header describes a loadable executable.
+	 *
+	 * @param ehdr Target ELF header.
+	 */
+	void checkElf(const Elf32_Ehdr &ehdr);
+
+	/**
+	 * @brief Reads the symbol table of an ELF32 file.
+	 *
+	 * @param fd   File descriptor of the ELF file.
+	 * @param ehdr ELF header of the file.
+	 *
+	 * @returns Named function, object and untyped symbols. Empty if the
+	 * file is stripped.
+	 */
+	std::vector<Image::Symbol> readElfSymbols(int fd, const Elf32_Ehdr &ehdr);
+}
+
+#endif // VMACHINE_IMAGE_H_
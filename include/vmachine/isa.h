@@ -69,11 +69,11 @@ namespace vmachine
 	 * @name Shifts for Instruction Fields
 	 */
 	/**@{*/
-	#define INST_SHIFT_FUNCT_7          0X18
-	#define INST_SHIFT_RS_1             0x0c
+	#define INST_SHIFT_FUNCT_7          0x19
+	#define INST_SHIFT_RS_1             0x0f
 	#define INST_SHIFT_RS_2             0x14
 	#define INST_SHIFT_FUNCT_3          0x0c
-	#define INST_SHIFT_RD               0x04
+	#define INST_SHIFT_RD               0x07
 	#define INST_SHIFT_IMMEDIATE_I_TYPE 0x14
 	#define INST_SHIFT_IMMEDIATE        0x0c
 	/**@}*/
@@ -82,14 +82,14 @@ namespace vmachine
 	 * @name Masks for Instruction Fields
 	 */
 	/**@{*/
-	#define INST_MASK_FUNCT_7           0xfe000000
-	#define INST_MASK_RS_1              0x000f8000
-	#define INST_MASK_RS_2              0x01f00000
-	#define INST_MASK_FUNCT_3           0x00007000
-	#define INST_MASK_RD                0x00000f80
+	#define INST_MASK_FUNCT_7           0x0000007f
+	#define INST_MASK_RS_1              0x0000001f
+	#define INST_MASK_RS_2              0x0000001f
+	#define INST_MASK_FUNCT_3           0x00000007
+	#define INST_MASK_RD                0x0000001f
 	#define INST_MASK_OPCODE            0x0000007f
-	#define INST_MASK_IMMEDIATE_I_TYPE  0xfff00000
-	#define INST_MASK_IMMEDIATE         0xfffff000
+	#define INST_MASK_IMMEDIATE_I_TYPE  0x00000fff
+	#define INST_MASK_IMMEDIATE         0x000fffff
 	/**@}*/
 
 	/**
@@ -25,10 +25,25 @@
 #ifndef MEMORY_H_
 #define MEMORY_H_
 
+	// Theirs
+	#include <cstddef>
+	#include <cstdint>
 	#include <iostream>
+	#include <vector>
+	#include <sys/types.h>
+
+	// Ours
+	#include <threadpool.h>
+	#include <config.h>
 
 	/**
 	 *  @brief Main Memory
+	 *
+	 *  @details Memory is backed by an anonymous private mapping, so pages
+	 *  are zero-filled on first touch and file contents can be mapped
+	 *  straight into it. File contents that cannot be mapped are filled
+	 *  in lazily: a page table marks the pages that still have to be read
+	 *  from their file, which happens on their first access.
 	 */
 	class Memory
 	{
@@ -44,6 +59,113 @@
 			 */
 			unsigned *data;
 
+			/**
+			 * @brief Host Page Size (in bytes)
+			 */
+			size_t pageSize_;
+
+			/**
+			 * @brief File region pending to be read in.
+			 */
+			struct Backing
+			{
+				unsigned addr;    /**< Target address.                       */
+				size_t size;      /**< Size of the region.                   */
+				int fd;           /**< Owned file descriptor, -1 if released. */
+				off_t offset;     /**< Offset of region in file.             */
+				unsigned pending; /**< Lazy pages that still need it.        */
+			};
+
+			/**
+			 * @brief Page Table
+			 *
+			 * @details An entry is zero for a resident page. For a lazy
+			 * page it is one plus the index of the first backing that was
+			 * registered after the page was last read in. A backing is
+			 * released once none of its pages is lazy any more, and
+			 * released backings are compacted away.
+			 */
+			/**@{*/
+			uint32_t *pages_;               /**< Entry of each guest page. */
+			std::vector<Backing> backings_; /**< Regions of lazy pages.    */
+			size_t released_;               /**< Released backings.        */
+			uint64_t faults_;               /**< Pages read in on demand.  */
+			/**@}*/
+
+			/**
+			 * @brief Reads in a run of lazy pages that share their page table entry.
+			 *
+			 * @param page  First page number.
+			 * @param count Number of pages.
+			 * @param entry Page table entry of the pages.
+			 */
+			void fill(unsigned page, unsigned count, uint32_t entry);
+
+			/**
+			 * @brief Reads in a lazy page.
+			 *
+			 * @param page Target page number.
+			 */
+			void fault(unsigned page);
+
+			/**
+			 * @brief Marks a lazy page as resident.
+			 *
+			 * @details Backings that no other lazy page needs are
+			 * released, and their file descriptors closed.
+			 *
+			 * @param page Target page number.
+			 */
+			void release(unsigned page);
+
+			/**
+			 * @brief Drops released backings and renumbers page table entries.
+			 */
+			void compact(void);
+
+			/**
+			 * @brief Prepares a range to be overwritten.
+			 *
+			 * @details Pending contents of pages that lie wholly in the
+			 * range are dropped without being read. Pages that straddle
+			 * its ends are read in.
+			 *
+			 * @param addr Start address.
+			 * @param size Size of the range (in bytes).
+			 */
+			void discard(unsigned addr, size_t size);
+
+			/**
+			 * @brief Reads in lazy pages with pending contents in a range.
+			 *
+			 * @param addr Start address.
+			 * @param size Size of the range (in bytes).
+			 */
+			void settle(unsigned addr, size_t size);
+
+			/**
+			 * @brief Registers a file region to be read in on demand.
+			 *
+			 * @param addr   Target address.
+			 * @param fd     Source file descriptor.
+			 * @param offset Offset of the region in the file.
+			 * @param size   Size of the region (in bytes).
+			 */
+			void defer(unsigned addr, int fd, off_t offset, size_t size);
+
+			/**
+			 * @brief Asserts that a range lies within the memory.
+			 *
+			 * @param addr Start address.
+			 * @param size Size of the range (in bytes).
+			 */
+			void check(unsigned addr, size_t size) const;
+
+			/**
+			 * @brief Access Latency (in cycles)
+			 */
+			unsigned latency_ = VMACHINE_DEFAULT_MEMORY_LATENCY;
+
 		public:
 
 			/**
@@ -58,6 +180,9 @@
 			 */
 			~Memory();
 
+			Memory(const Memory &) = delete;
+			Memory &operator=(const Memory &) = delete;
+
 			/**
 			 * @brief Dumps the context of the target memory.
 			 *
@@ -85,6 +210,73 @@
 			 * @todo Use custom types.
 			 */
 			void write(unsigned addr, unsigned word);
+
+			/**
+			 * @brief Writes consecutive words to the target memory.
+			 *
+			 * @param addr  Target address.
+			 * @param words Words.
+			 * @param count Number of words.
+			 */
+			void write(unsigned addr, const unsigned *words, size_t count);
+
+			/**
+			 * @brief Loads a region of a file into the target memory.
+			 *
+			 * @details Whole pages are mapped private and copy-on-write
+			 * when @p addr and @p offset are congruent modulo the host
+			 * page size. Anything else is read in on first access.
+			 *
+			 * @param addr   Target address.
+			 * @param fd     Source file descriptor.
+			 * @param offset Offset of the region in the file.
+			 * @param size   Size of the region (in bytes).
+			 */
+			void map(unsigned addr, int fd, off_t offset, size_t size);
+
+			/**
+			 * @brief Reads in all lazy pages.
+			 *
+			 * @details Pages are read in runs of up to
+			 * #VMACHINE_LOAD_CHUNK_SIZE bytes, concurrently on @p pool.
+			 * Reading ahead of mapped file pages is also requested.
+			 *
+			 * @param pool Thread pool where reads should run.
+			 */
+			void populate(ThreadPool &pool);
+
+			/**
+			 * @brief Zero-fills a range of the target memory.
+			 *
+			 * @details Whole pages are replaced by fresh anonymous pages,
+			 * which the host only zero-fills when first touched.
+			 *
+			 * @param addr Target address.
+			 * @param size Size of the range (in bytes).
+			 */
+			void zero(unsigned addr, size_t size);
+
+			/**
+			 * @brief Gets the size of the memory (in bytes).
+			 */
+			unsigned getSize(void) const { return (size_); }
+
+			/**
+			 * @brief Gets the number of pages read in on demand.
+			 */
+			uint64_t getFaults(void) const { return (faults_); }
+
+			/**
+			 * @brief Sets the access latency.
+			 *
+			 * @param latency Access latency (in cycles).
+			 */
+			void setLatency(unsigned latency) { latency_ = latency; }
+
+			/**
+			 * @brief Gets the access latency (in cycles).
+			 */
+			unsigned getLatency(void) const { return (latency_); }
 	};
 
 #endif // MEMORY_H_
\ No newline at end of file
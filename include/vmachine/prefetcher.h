@@ -0,0 +1,321 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef VMACHINE_PREFETCHER_H_
+#define VMACHINE_PREFETCHER_H_
+
+	// Theirs
+	#include <cstdint>
+
+	// Ours
+	#include <arch.h>
+	#include <config.h>
+
+	/**
+	 * @brief Prefetch Statistics
+	 */
+	struct PrefetchStats
+	{
+		uint64_t issued;    /**< Prefetches that filled a line.               */
+		uint64_t useful;    /**< Prefetched lines later hit by a demand.      */
+		uint64_t late;      /**< Demand misses on a line still in the queue.  */
+		uint64_t polluting; /**< Demand misses on a line evicted by a prefetch. */
+	};
+
+	/**
+	 * @brief Prefetch Queue
+	 *
+	 * @details Bounded FIFO of line addresses waiting to be prefetched.
+	 * Requests are dropped when the queue is full or already holds the
+	 * same line, so prefetchers never stall the demand path.
+	 */
+	class PrefetchQueue
+	{
+		private:
+
+			/**
+			 * @brief Capacity.
+			 */
+			unsigned capacity_;
+
+			/**
+			 * @brief Queued line addresses.
+			 */
+			isa32::word_t *lines;
+
+			/**
+			 * @brief Head and number of queued lines.
+			 */
+			/**@{*/
+			unsigned head_;
+			unsigned count_;
+			/**@}*/
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param capacity Maximum number of queued lines.
+			 */
+			PrefetchQueue(unsigned capacity = VMACHINE_PREFETCH_QUEUE_SIZE);
+
+			/**
+			 * @brief Default destructor.
+			 */
+			~PrefetchQueue();
+
+			PrefetchQueue(const PrefetchQueue &) = delete;
+			PrefetchQueue &operator=(const PrefetchQueue &) = delete;
+
+			/**
+			 * @brief Enqueues a line address.
+			 *
+			 * @param line Target line address.
+			 *
+			 * @returns True if the line was enqueued, false otherwise.
+			 */
+			bool push(isa32::word_t line);
+
+			/**
+			 * @brief Dequeues the oldest line address.
+			 *
+			 * @param line Where to store the line address.
+			 *
+			 * @returns True if a line was dequeued, false if the queue is empty.
+			 */
+			bool pop(isa32::word_t &line);
+
+			/**
+			 * @brief Removes a line address, if queued.
+			 *
+			 * @param line Target line address.
+			 *
+			 * @returns True if the line was queued, false otherwise.
+			 */
+			bool remove(isa32::word_t line);
+
+			/**
+			 * @brief Drops all queued line addresses.
+			 */
+			void clear(void) { count_ = 0; }
+	};
+
+	/**
+	 * @brief Hardware Prefetcher
+	 */
+	class Prefetcher
+	{
+		friend class Cache;
+
+		public:
+
+			/**
+			 * @brief Outcome of a demand access.
+			 */
+			enum Event
+			{
+				HIT,          /**< Hit on a demand-fetched line. */
+				PREFETCH_HIT, /**< First hit on a prefetched line. */
+				MISS          /**< Miss. */
+			};
+
+		protected:
+
+			unsigned degree_;    /**< Lines prefetched per trigger.           */
+			unsigned distance_;  /**< How far ahead the first prefetch goes.  */
+			unsigned lineShift_; /**< log2 of the line size of the cache.     */
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param degree   Lines prefetched per trigger.
+			 * @param distance How far ahead (in strides) the first prefetch goes.
+			 */
+			Prefetcher(unsigned degree, unsigned distance) :
+				degree_(degree),
+				distance_(distance),
+				lineShift_(0)
+			{ }
+
+			/**
+			 * @brief Default destructor.
+			 */
+			virtual ~Prefetcher() { }
+
+			/**
+			 * @brief Observes a demand access.
+			 *
+			 * @param addr  Target address.
+			 * @param pc    Program counter of the access.
+			 * @param event Outcome of the access.
+			 * @param queue Queue where prefetches should be placed.
+			 */
+			virtual void train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue) = 0;
+	};
+
+	/**
+	 * @brief Next-Line Prefetcher
+	 *
+	 * @details Prefetches the lines that follow a miss, or a first hit
+	 * on a prefetched line (tagged prefetching).
+	 */
+	class NextLinePrefetcher : public Prefetcher
+	{
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param degree   Lines prefetched per trigger.
+			 * @param distance How far ahead (in lines) the first prefetch goes.
+			 */
+			NextLinePrefetcher(
+				unsigned degree = VMACHINE_DEFAULT_PREFETCH_DEGREE,
+				unsigned distance = VMACHINE_DEFAULT_PREFETCH_DISTANCE
+			) : Prefetcher(degree, distance) { }
+
+			void train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue) override;
+	};
+
+	/**
+	 * @brief Stride Prefetcher
+	 *
+	 * @details Reference prediction table indexed by the program counter.
+	 * Each entry walks through the initial, transient, steady and
+	 * no-prediction states, and prefetches only while steady.
+	 */
+	class StridePrefetcher : public Prefetcher
+	{
+		private:
+
+			/**
+			 * @brief Number of table entries (power of two).
+			 */
+			static const unsigned TABLE_SIZE = 64;
+
+			/**
+			 * @brief States of a table entry.
+			 */
+			enum State { INITIAL, TRANSIENT, STEADY, NO_PREDICTION };
+
+			/**
+			 * @brief Table entry.
+			 */
+			struct Entry
+			{
+				isa32::word_t pc;    /**< Tag.                 */
+				isa32::word_t addr;  /**< Last address.        */
+				int32_t stride;      /**< Last stride.         */
+				State state;         /**< Prediction state.    */
+				bool valid;          /**< Is this entry valid? */
+			};
+
+			/**
+			 * @brief Reference prediction table.
+			 */
+			Entry table[TABLE_SIZE];
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param degree   Lines prefetched per trigger.
+			 * @param distance How far ahead (in strides) the first prefetch goes.
+			 */
+			StridePrefetcher(
+				unsigned degree = VMACHINE_DEFAULT_PREFETCH_DEGREE,
+				unsigned distance = VMACHINE_DEFAULT_PREFETCH_DISTANCE
+			);
+
+			void train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue) override;
+	};
+
+	/**
+	 * @brief Stream Prefetcher
+	 *
+	 * @details Tracks a few streams of misses within a window of lines,
+	 * and runs ahead of a stream once its direction is confirmed.
+	 */
+	class StreamPrefetcher : public Prefetcher
+	{
+		private:
+
+			/**
+			 * @brief Number of tracked streams.
+			 */
+			static const unsigned STREAMS_NUM = 8;
+
+			/**
+			 * @brief Window (in lines) around the head of a stream.
+			 */
+			static const int32_t WINDOW = 16;
+
+			/**
+			 * @brief Accesses in the same direction that confirm a stream.
+			 */
+			static const unsigned CONFIRMATIONS = 2;
+
+			/**
+			 * @brief Stream tracker.
+			 */
+			struct Stream
+			{
+				isa32::word_t head;  /**< Last line of the stream.     */
+				int32_t direction;   /**< +1, -1 or 0 if unknown.      */
+				unsigned confidence; /**< Confirmations so far.        */
+				uint32_t stamp;      /**< Last use, for replacement.   */
+				bool valid;          /**< Is this tracker in use?      */
+			};
+
+			/**
+			 * @brief Stream trackers.
+			 */
+			Stream streams[STREAMS_NUM];
+
+			/**
+			 * @brief Current replacement stamp.
+			 */
+			uint32_t clock_;
+
+		public:
+
+			/**
+			 * @brief Default constructor.
+			 *
+			 * @param degree   Lines prefetched per trigger.
+			 * @param distance How far ahead (in lines) the first prefetch goes.
+			 */
+			StreamPrefetcher(
+				unsigned degree = VMACHINE_DEFAULT_PREFETCH_DEGREE,
+				unsigned distance = VMACHINE_DEFAULT_PREFETCH_DISTANCE
+			);
+
+			void train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue) override;
+	};
+
+#endif // VMACHINE_PREFETCHER_H_
@@ -0,0 +1,126 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef VMACHINE_SYMBOLS_H_
+#define VMACHINE_SYMBOLS_H_
+
+	// Theirs
+	#include <string>
+	#include <vector>
+
+	// Ours
+	#include <arch.h>
+
+namespace vmachine
+{
+	/**
+	 * @brief Symbol Index
+	 *
+	 * @details Maps guest addresses back to the symbols that contain
+	 * them. Symbols are kept sorted by address, and their names are
+	 * packed into a single pool, so that lookups are a binary search.
+	 */
+	class SymbolIndex
+	{
+		public:
+
+			/**
+			 * @brief Symbol
+			 */
+			struct Symbol
+			{
+				isa32::word_t addr; /**< Start address.                  */
+				isa32::word_t size; /**< Size (zero if unknown).         */
+				uint32_t name;      /**< Offset of name in name pool.    */
+			};
+
+		private:
+
+			/**
+			 * @brief Symbols, sorted by address.
+			 */
+			std::vector<Symbol> symbols_;
+
+			/**
+			 * @brief Name Pool
+			 */
+			std::vector<char> names_;
+
+		public:
+
+			/**
+			 * @brief Adds a symbol.
+			 *
+			 * @details Symbols may be added in any order, but must be
+			 * sorted with build() before any lookup.
+			 *
+			 * @param name Name.
+			 * @param addr Start address.
+			 * @param size Size (zero if unknown).
+			 */
+			void add(const std::string &name, isa32::word_t addr, isa32::word_t size);
+
+			/**
+			 * @brief Sorts the index.
+			 *
+			 * @details Of the symbols that share an address, only the
+			 * largest one is kept.
+			 */
+			void build(void);
+
+			/**
+			 * @brief Looks up the symbol that contains an address.
+			 *
+			 * @details A symbol of unknown size extends up to the next one.
+			 *
+			 * @param addr Target address.
+			 *
+			 * @returns The matching symbol, or nullptr if none.
+			 */
+			const Symbol *lookup(isa32::word_t addr) const;
+
+			/**
+			 * @brief Gets the name of a symbol.
+			 *
+			 * @param sym Target symbol.
+			 */
+			const char *getName(const Symbol &sym) const { return (&names_[sym.name]); }
+
+			/**
+			 * @brief Describes an address as symbol+offset.
+			 *
+			 * @param addr Target address.
+			 *
+			 * @returns The description, or the address in hex if no symbol contains it.
+			 */
+			std::string describe(isa32::word_t addr) const;
+
+			/**
+			 * @brief Gets the number of symbols.
+			 */
+			size_t size(void) const { return (symbols_.size()); }
+	};
+}
+
+#endif // VMACHINE_SYMBOLS_H_
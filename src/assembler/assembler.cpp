@@ -23,60 +23,402 @@
 //
 
 // Theirs
-#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Ours
 #include <assembler.h>
 
-// Assembles a source file.
-void Assembler::assembly(std::istream &input)
+// Reads a source in chunks of complete lines.
+void Assembler::readChunks(std::istream &input, const std::function<void(std::string_view)> &fn)
+{
+	std::vector<char> chunk(ASSEMBLER_CHUNK_SIZE + 1);
+	size_t pending = 0;
+
+	while (input)
+	{
+		// Top up the chunk after the partial line of the previous one.
+		input.read(&chunk[pending], chunk.size() - 1 - pending);
+		size_t size = pending + input.gcount();
+		bool eof = !input;
+
+		// Complete lines only, unless this is the last chunk.
+		size_t end = size;
+		if (!eof)
+		{
+			while ((end > 0) && (chunk[end - 1] != '\n'))
+				end--;
+
+			// A single line larger than the chunk.
+			if (end == 0)
+			{
+				pending = size;
+				chunk.resize(2*chunk.size());
+				continue;
+			}
+		}
+
+		if (end > 0)
+			fn(std::string_view(&chunk[0], end));
+
+		// Carry over the partial line.
+		pending = size - end;
+		memmove(&chunk[0], &chunk[end], pending);
+	}
+}
+
+// Assembles a line.
+size_t Assembler::assembly(std::string_view line, isa32::word_t *words) const
+{
+	Tokens tokens;
+	Reference refs[ASSEMBLER_MAX_EXPANSION];
+
+	if (!tokenize(uncomment(line), tokens))
+		throw std::invalid_argument("too many tokens");
+
+	// Blank line.
+	if (tokens.size() == 0)
+		return (0);
+
+	size_t count = expand_instruction(tokens, words, refs);
+
+	// Nothing to resolve the symbol against.
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!refs[i].symbol.empty())
+			throw std::invalid_argument("undefined symbol");
+	}
+
+	return (count);
+}
+
+// Assembles a line into an object.
+bool Assembler::assembly(std::string_view line, Object &obj, unsigned &section) const
 {
-	std::string line;
+	Tokens tokens;
+
+	line = uncomment(line);
+
+	if (!tokenize(line, tokens))
+		throw std::invalid_argument("too many tokens");
+
+	// Labels.
+	while ((tokens.size() > 0) && (tokens[0].back() == ':'))
+	{
+		std::string_view name = tokens[0].substr(0, tokens[0].size() - 1);
+		Location here = { section, obj.sections[section].size() };
+
+		if (isLocalLabel(name))
+			obj.locals[std::string(name)].push_back(here);
+		else if (!isSymbol(name) || !obj.labels.emplace(name, here).second)
+			throw std::invalid_argument("invalid or duplicate label");
+
+		line.remove_prefix(tokens[0].data() + tokens[0].size() - line.data());
+		tokenize(line, tokens);
+	}
+
+	// Blank line.
+	if (tokens.size() == 0)
+		return (false);
+
+	std::vector<isa32::word_t> &words = obj.sections[section];
 
-	// Read all lines.
-	while (std::getline(input, line))
+	// Records a reference to a symbol from the next word.
+	auto reference = [&](const Reference &ref) {
+		size_t ordinal = 0;
+
+		if (isLocalReference(ref.symbol))
+		{
+			auto it = obj.locals.find(std::string(ref.symbol.substr(0, ref.symbol.size() - 1)));
+			ordinal = (it != obj.locals.end()) ? it->second.size() : 0;
+		}
+
+		obj.relocations.push_back({ref.type, {section, words.size()}, std::string(ref.symbol), ordinal});
+	};
+
+	// Instruction.
+	if (tokens[0][0] != '.')
 	{
-		const char *token;
-		std::vector<const char *> tokens;
-		char *line2 = strdup(line.c_str());
+		isa32::word_t insts[ASSEMBLER_MAX_EXPANSION];
+		Reference refs[ASSEMBLER_MAX_EXPANSION];
+		size_t count = expand_instruction(tokens, insts, refs);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!refs[i].symbol.empty())
+				reference(refs[i]);
+			words.push_back(insts[i]);
+		}
+	}
 
-		// Parse line.
-		if ((token = std::strtok(line2, delim)) != NULL)
+	// Directives.
+	else if (tokens[0] == ".text")
+	{
+		section = ASSEMBLER_SECTION_TEXT;
+		return (true);
+	}
+	else if (tokens[0] == ".data")
+	{
+		section = ASSEMBLER_SECTION_DATA;
+		return (true);
+	}
+	else if ((tokens[0] == ".globl") || (tokens[0] == ".global"))
+	{
+		for (size_t i = 1; i < tokens.size(); i++)
+		{
+			if (!isSymbol(tokens[i]) || isLocalReference(tokens[i]))
+				throw std::invalid_argument("invalid operand");
+			obj.globals.emplace(tokens[i]);
+		}
+	}
+	else if (tokens[0] == ".word")
+	{
+		for (size_t i = 1; i < tokens.size(); i++)
 		{
-			do
-				tokens.push_back(token);
-			while ((token = std::strtok(NULL, delim)) != NULL);
+			isa32::word_t value = 0;
 
-			encode_instruction(tokens);
+			if (!parseNumber(tokens[i], value))
+			{
+				if (!isSymbol(tokens[i]))
+					throw std::invalid_argument("invalid operand");
+				reference({RELOC_ABS32, tokens[i]});
+			}
+			words.push_back(value);
 		}
+	}
+	else if (tokens[0] == ".space")
+	{
+		isa32::word_t size = 0;
 
-		free(line2);
+		if (!parseNumber(tokens[1], size))
+			throw std::invalid_argument("invalid operand");
+
+		// Whole words only.
+		words.resize(words.size() + (size + sizeof(isa32::word_t) - 1)/sizeof(isa32::word_t), 0);
 	}
+	else
+		throw std::invalid_argument("unknown directive");
+
+	return (false);
 }
 
 // Assembles a source file.
-isa32::word_t Assembler::assembly(std::string &line)
+void Assembler::assembly(std::istream &input, const emit_fn &emit) const
+{
+	std::vector<isa32::word_t> words;
+
+	readChunks(input, [&](std::string_view chunk) {
+		words.clear();
+		splitLines(chunk, [&](std::string_view line) {
+			isa32::word_t insts[ASSEMBLER_MAX_EXPANSION];
+			size_t count = assembly(line, insts);
+
+			words.insert(words.end(), insts, insts + count);
+		});
+
+		if (!words.empty())
+			emit(words.data(), words.size());
+	});
+}
+
+// Assembles a command.
+isa32::word_t Assembler::assembly(std::string_view line) const
 {
-	isa32::word_t inst;
-	const char *token;
-	std::vector<const char *> tokens;
-	char *line2 = strdup(line.c_str());
+	isa32::word_t insts[ASSEMBLER_MAX_EXPANSION] = { 0 };
 
-	// Parse line.
-	if ((token = std::strtok(line2, delim)) != NULL)
+	if (assembly(line, insts) > 1)
+		throw std::invalid_argument("instruction spans several words");
+
+	return (insts[0]);
+}
+
+// Appends an object to another.
+static void append(Object &obj, Object &part)
+{
+	size_t offsets[ASSEMBLER_NR_SECTIONS];
+
+	for (unsigned i = 0; i < ASSEMBLER_NR_SECTIONS; i++)
+	{
+		offsets[i] = obj.sections[i].size();
+		obj.sections[i].insert(obj.sections[i].end(), part.sections[i].begin(), part.sections[i].end());
+	}
+
+	auto shift = [&](Location loc) {
+		loc.offset += offsets[loc.section];
+		return (loc);
+	};
+
+	// Local references also count the definitions before the part.
+	for (Relocation &reloc : part.relocations)
+	{
+		if (isLocalReference(reloc.symbol))
+		{
+			auto it = obj.locals.find(reloc.symbol.substr(0, reloc.symbol.size() - 1));
+			if (it != obj.locals.end())
+				reloc.ordinal += it->second.size();
+		}
+		reloc.where = shift(reloc.where);
+		obj.relocations.push_back(std::move(reloc));
+	}
+
+	for (const auto &label : part.labels)
+	{
+		if (!obj.labels.emplace(label.first, shift(label.second)).second)
+			throw std::invalid_argument("invalid or duplicate label");
+	}
+
+	for (const auto &local : part.locals)
+	{
+		std::vector<Location> &defs = obj.locals[local.first];
+		for (const Location &loc : local.second)
+			defs.push_back(shift(loc));
+	}
+
+	obj.globals.insert(part.globals.begin(), part.globals.end());
+}
+
+// Assembles chunks of complete lines into an object.
+Object Assembler::assembleObject(const std::vector<std::string_view> &chunks, ThreadPool &pool) const
+{
+	// Chunk of the source, assembled on its own.
+	struct Part
 	{
-		do
-			tokens.push_back(token);
-		while ((token = std::strtok(NULL, delim)) != NULL);
+		std::string_view source; // Complete lines.
+		Object obj;              // Assembled chunk.
+		bool switched;           // Any section directive?
+		unsigned section;        // Section at the end.
+	};
+
+	std::vector<Part> parts;
+	for (std::string_view chunk : chunks)
+		parts.push_back({chunk, Object(), false, ASSEMBLER_SECTION_TEXT});
+
+	auto assembleChunk = [this, &parts](size_t i, unsigned section) {
+		Part &part = parts[i];
+
+		part.obj = Object();
+		part.switched = false;
+		splitLines(part.source, [&](std::string_view line) {
+			part.switched = assembly(line, part.obj, section) || part.switched;
+		});
+		part.section = section;
+	};
+
+	auto assembleChunks = [&](const std::vector<size_t> &which, const std::vector<unsigned> &sections) {
+		if (which.size() == 1)
+			assembleChunk(which[0], sections[which[0]]);
+		else
+			pool.run(which.size(), [&](size_t i) { assembleChunk(which[i], sections[which[i]]); });
+	};
+
+	// Guess that every chunk starts in the text section.
+	std::vector<size_t> all(parts.size());
+	std::vector<unsigned> sections(parts.size(), ASSEMBLER_SECTION_TEXT);
+	for (size_t i = 0; i < parts.size(); i++)
+		all[i] = i;
+	assembleChunks(all, sections);
 
-		inst = encode_instruction(tokens);
+	// Assemble again the chunks that start elsewhere.
+	std::vector<size_t> wrong;
+	for (size_t i = 1; i < parts.size(); i++)
+	{
+		sections[i] = parts[i - 1].switched ? parts[i - 1].section : sections[i - 1];
+		if (sections[i] != ASSEMBLER_SECTION_TEXT)
+			wrong.push_back(i);
 	}
+	if (!wrong.empty())
+		assembleChunks(wrong, sections);
+
+	Object obj;
+	for (Part &part : parts)
+		append(obj, part.obj);
+
+	return (obj);
+}
 
-	free(line2);
+// Assembles a source file into a relocatable object.
+Object Assembler::assembleObject(std::istream &input, ThreadPool &pool) const
+{
+	std::vector<std::string> storage;
+	std::vector<std::string_view> chunks;
+
+	readChunks(input, [&](std::string_view chunk) {
+		storage.emplace_back(chunk);
+	});
+	for (const std::string &chunk : storage)
+		chunks.push_back(chunk);
+
+	return (assembleObject(chunks, pool));
+}
 
-	return (inst);
-}
\ No newline at end of file
+// Assembles a source in memory into a relocatable object.
+Object Assembler::assembleObject(std::string_view source, ThreadPool &pool) const
+{
+	std::vector<std::string_view> chunks;
+
+	// Cut after the last line that fits in a chunk.
+	while (!source.empty())
+	{
+		size_t end = source.size();
+
+		if (end > ASSEMBLER_CHUNK_SIZE)
+		{
+			end = source.rfind('\n', ASSEMBLER_CHUNK_SIZE - 1);
+
+			// A single line larger than the chunk.
+			if (end == std::string_view::npos)
+				end = source.find('\n', ASSEMBLER_CHUNK_SIZE);
+			end = (end == std::string_view::npos) ? source.size() : end + 1;
+		}
+
+		chunks.push_back(source.substr(0, end));
+		source.remove_prefix(end);
+	}
+
+	return (assembleObject(chunks, pool));
+}
+
+// Assembles a source file into a program.
+Program Assembler::assemble(std::istream &input, isa32::word_t base, ThreadPool &pool) const
+{
+	Object obj = assembleObject(input, pool);
+
+	return (link({&obj}, base, pool));
+}
+
+// Assembles a source in memory into a program.
+Program Assembler::assemble(std::string_view source, isa32::word_t base, ThreadPool &pool) const
+{
+	Object obj = assembleObject(source, pool);
+
+	return (link({&obj}, base, pool));
+}
+
+// Encodes an instruction, or the instructions of a pseudo-instruction.
+size_t Assembler::expand_instruction(const Tokens &inst, isa32::word_t *words, Reference *refs) const
+{
+	words[0] = encode_instruction(inst, refs[0]);
+
+	return (1);
+}
+
+// Gets the version of the encoding.
+unsigned Assembler::version(void) const
+{
+	return (ASSEMBLER_VERSION);
+}
+
+// Patches a word with the address of a symbol.
+isa32::word_t Assembler::relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const
+{
+	((void) pc);
+
+	if (type != RELOC_ABS32)
+		throw std::invalid_argument("unknown relocation");
+
+	return (word + value);
+}
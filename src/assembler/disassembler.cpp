@@ -0,0 +1,55 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <cstddef>
+
+// Ours
+#include <disassembler.h>
+
+// Disassembles an instruction.
+size_t Disassembler::disassemble(isa32::word_t inst, char *buf, size_t size) const
+{
+	TextBuffer out(buf, size);
+
+	format(inst, out);
+
+	return (out.finish());
+}
+
+// Disassembles a range of memory.
+size_t Disassembler::disassemble(const isa32::word_t *words, size_t count, isa32::word_t base, char *buf, size_t size) const
+{
+	TextBuffer out(buf, size);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		out.putHex(base + i*sizeof(isa32::word_t), 8);
+		out.put(":\t");
+		format(words[i], out);
+		out.put('\n');
+	}
+
+	return (out.finish());
+}
@@ -0,0 +1,191 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Ours
+#include <assembler.h>
+
+// Lays out an object and resolves its references.
+Program Assembler::link(const Object &obj, isa32::word_t base) const
+{
+	return (link(std::vector<const Object *>{&obj}, base));
+}
+
+// Links objects into a program.
+Program Assembler::link(const std::vector<const Object *> &objects, isa32::word_t base, ThreadPool &pool) const
+{
+	Program prog;
+	std::vector<std::array<isa32::word_t, ASSEMBLER_NR_SECTIONS>> bases(objects.size());
+	std::vector<isa32::word_t> bounds;
+
+	// Sections of the same kind back to back.
+	prog.base = base;
+	for (unsigned i = 0; i < ASSEMBLER_NR_SECTIONS; i++)
+	{
+		for (size_t k = 0; k < objects.size(); k++)
+		{
+			const std::vector<isa32::word_t> &section = objects[k]->sections[i];
+
+			bases[k][i] = base + prog.words.size()*sizeof(isa32::word_t);
+			bounds.push_back(bases[k][i]);
+			prog.words.insert(prog.words.end(), section.begin(), section.end());
+		}
+
+		if (i == ASSEMBLER_SECTION_TEXT)
+			prog.textSize = prog.words.size();
+	}
+	bounds.push_back(base + prog.words.size()*sizeof(isa32::word_t));
+
+	auto address = [&](size_t k, const Location &loc) -> isa32::word_t {
+		return (bases[k][loc.section] + loc.offset*sizeof(isa32::word_t));
+	};
+
+	// Exported labels.
+	std::unordered_map<std::string_view, isa32::word_t> globals;
+	for (size_t k = 0; k < objects.size(); k++)
+	{
+		for (const std::string &name : objects[k]->globals)
+		{
+			auto it = objects[k]->labels.find(name);
+
+			// Defined elsewhere.
+			if (it == objects[k]->labels.end())
+				continue;
+
+			if (!globals.emplace(name, address(k, it->second)).second)
+				throw std::invalid_argument("duplicate symbol");
+		}
+	}
+
+	// Resolves a reference of an object.
+	auto resolve = [&](size_t k, const Relocation &reloc) -> isa32::word_t {
+		const Object &obj = *objects[k];
+
+		if (isLocalReference(reloc.symbol))
+		{
+			auto it = obj.locals.find(reloc.symbol.substr(0, reloc.symbol.size() - 1));
+			bool backward = (reloc.symbol.back() == 'b');
+			size_t count = (it != obj.locals.end()) ? it->second.size() : 0;
+
+			// 1b is the last definition before, 1f the first one after.
+			if (backward ? (reloc.ordinal == 0) : (reloc.ordinal >= count))
+				throw std::invalid_argument("undefined local label");
+
+			return (address(k, it->second[reloc.ordinal - (backward ? 1 : 0)]));
+		}
+
+		auto label = obj.labels.find(reloc.symbol);
+		if (label != obj.labels.end())
+			return (address(k, label->second));
+
+		auto global = globals.find(reloc.symbol);
+		if (global == globals.end())
+			throw std::invalid_argument("undefined symbol");
+
+		return (global->second);
+	};
+
+	// Blocks of relocations, each patching words of its own.
+	struct Block
+	{
+		size_t object; // Object of the relocations.
+		size_t first;  // First relocation.
+		size_t last;   // Past the last relocation.
+	};
+
+	std::vector<Block> blocks;
+	for (size_t k = 0; k < objects.size(); k++)
+	{
+		size_t count = objects[k]->relocations.size();
+
+		for (size_t first = 0; first < count; first += ASSEMBLER_LINK_BLOCK)
+			blocks.push_back({k, first, std::min(count, first + ASSEMBLER_LINK_BLOCK)});
+	}
+
+	auto apply = [&](size_t b) {
+		const Block &block = blocks[b];
+
+		for (size_t r = block.first; r < block.last; r++)
+		{
+			const Relocation &reloc = objects[block.object]->relocations[r];
+			isa32::word_t pc = address(block.object, reloc.where);
+			isa32::word_t &word = prog.words[(pc - base)/sizeof(isa32::word_t)];
+
+			word = relocate(word, reloc.type, pc, resolve(block.object, reloc));
+		}
+	};
+
+	if (blocks.size() == 1)
+		apply(0);
+	else if (blocks.size() > 1)
+		pool.run(blocks.size(), apply);
+
+	// A symbol extends up to the next one in its section.
+	for (size_t k = 0; k < objects.size(); k++)
+	{
+		for (const auto &label : objects[k]->labels)
+			prog.symbols.push_back({label.first, address(k, label.second), 0});
+	}
+	std::sort(prog.symbols.begin(), prog.symbols.end(), [](const Program::Symbol &a, const Program::Symbol &b) {
+		return (a.value < b.value);
+	});
+	for (size_t i = 0; i < prog.symbols.size(); i++)
+	{
+		isa32::word_t end = *std::upper_bound(bounds.begin(), bounds.end() - 1, prog.symbols[i].value);
+
+		if ((i + 1 < prog.symbols.size()) && (prog.symbols[i + 1].value < end))
+			end = prog.symbols[i + 1].value;
+
+		prog.symbols[i].size = end - prog.symbols[i].value;
+	}
+
+	// Entry point.
+	prog.entry = base;
+	auto start = globals.find("_start");
+	if (start != globals.end())
+		prog.entry = start->second;
+	else
+	{
+		for (size_t k = 0; k < objects.size(); k++)
+		{
+			auto it = objects[k]->labels.find("_start");
+
+			if (it != objects[k]->labels.end())
+			{
+				prog.entry = address(k, it->second);
+				break;
+			}
+		}
+	}
+
+	return (prog);
+}
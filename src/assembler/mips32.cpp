@@ -23,13 +23,17 @@
 //
 
 // Theirs
-#include <cstdlib>
+#include <array>
+#include <cstdint>
 #include <iostream>
-#include <unordered_map>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 // Ours
 #include <asm/mips32.h>
 #include <arch/mips32.h>
+#include <perfecthash.h>
 
 using namespace mips32;
 
@@ -42,24 +46,26 @@ class Instruction
 
 		isa32::word_t opcode;
 		isa32::word_t funct;
-		isa32::word_t(*encode)(const std::vector<const char *> &tokens);
+		isa32::word_t(*encode)(const Instruction &i, const Tokens &tokens, Reference &ref);
 };
 
 // Forward definitions.
-static isa32::word_t encode_instruction_R_generic(const std::vector<const char *> &inst);
-static isa32::word_t encode_instruction_R_shift(const std::vector<const char *> &tokens);
-static isa32::word_t encode_instruction_R_muldiv(const std::vector<const char *> &tokens);
-static isa32::word_t encode_instruction_R_jr(const std::vector<const char *> &tokens);
-static isa32::word_t encode_instruction_I_generic(const std::vector<const char *> &inst);
-static isa32::word_t encode_instruction_I_ls(const std::vector<const char *> &inst);
-static isa32::word_t encode_instruction_J_generic(const std::vector<const char *> &inst);
+static isa32::word_t encode_instruction_R_generic(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_R_shift(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_R_muldiv(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_R_jr(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_I_generic(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_I_lui(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_I_ls(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_I_branch(const Instruction &i, const Tokens &tokens, Reference &ref);
+static isa32::word_t encode_instruction_J_generic(const Instruction &i, const Tokens &tokens, Reference &ref);
 
 //==============================================================================
 // Lookup Tables
 //==============================================================================
 
 // Map of Registers
-static std::unordered_map<std::string, uint32_t> registers = {
+static constexpr auto registers = makePerfectHash<uint32_t>({
 	{ REG_NAME_ZERO , REG_ZERO,  },
 	{ REG_NAME_AT,    REG_AT,    },
 	{ REG_NAME_V0,    REG_V0,    },
@@ -92,10 +98,10 @@ static std::unordered_map<std::string, uint32_t> registers = {
 	{ REG_NAME_SP,    REG_SP,    },
 	{ REG_NAME_FP,    REG_FP,    },
 	{ REG_NAME_RA,    REG_RA,    },
-};
+});
 
 // Map of Instructions
-static std::unordered_map<std::string, Instruction> instructions = {
+static constexpr auto instructions = makePerfectHash<Instruction>({
 	{ INST_NAME_ADD,  { INST_OPCODE_ADD,  INST_FUNCT_ADD,  encode_instruction_R_generic } },
 	{ INST_NAME_ADDI, { INST_OPCODE_ADDI, INST_FUNCT_NONE, encode_instruction_I_generic } },
 	{ INST_NAME_SUB,  { INST_OPCODE_SUB,  INST_FUNCT_SUB,  encode_instruction_R_generic } },
@@ -105,41 +111,106 @@ static std::unordered_map<std::string, Instruction> instructions = {
 	{ INST_NAME_ANDI, { INST_OPCODE_ANDI, INST_FUNCT_NONE, encode_instruction_I_generic } },
 	{ INST_NAME_OR,   { INST_OPCODE_OR,   INST_FUNCT_OR,   encode_instruction_R_generic } },
 	{ INST_NAME_ORI,  { INST_OPCODE_ORI,  INST_FUNCT_NONE, encode_instruction_I_generic } },
+	{ INST_NAME_LUI,  { INST_OPCODE_LUI,  INST_FUNCT_NONE, encode_instruction_I_lui     } },
 	{ INST_NAME_XOR,  { INST_OPCODE_XOR,  INST_FUNCT_XOR,  encode_instruction_R_generic } },
-	{ INST_NAME_XOR,  { INST_OPCODE_NOR,  INST_FUNCT_NOR,  encode_instruction_R_generic } },
+	{ INST_NAME_NOR,  { INST_OPCODE_NOR,  INST_FUNCT_NOR,  encode_instruction_R_generic } },
 	{ INST_NAME_SLT,  { INST_OPCODE_SLT,  INST_FUNCT_SLT,  encode_instruction_R_generic } },
 	{ INST_NAME_SLTI, { INST_OPCODE_SLTI, INST_FUNCT_NONE, encode_instruction_I_generic } },
 	{ INST_NAME_SLL,  { INST_OPCODE_SLL,  INST_FUNCT_SLL,  encode_instruction_R_shift   } },
 	{ INST_NAME_SRL,  { INST_OPCODE_SRL,  INST_FUNCT_SRL,  encode_instruction_R_shift   } },
 	{ INST_NAME_LW,   { INST_OPCODE_LW,   INST_FUNCT_NONE, encode_instruction_I_ls      } },
 	{ INST_NAME_SW,   { INST_OPCODE_SW,   INST_FUNCT_NONE, encode_instruction_I_ls      } },
-	{ INST_NAME_BEQ,  { INST_OPCODE_BEQ,  INST_FUNCT_NONE, encode_instruction_I_generic } },
-	{ INST_NAME_BNE,  { INST_OPCODE_BNE,  INST_FUNCT_NONE, encode_instruction_I_generic } },
+	{ INST_NAME_BEQ,  { INST_OPCODE_BEQ,  INST_FUNCT_NONE, encode_instruction_I_branch  } },
+	{ INST_NAME_BNE,  { INST_OPCODE_BNE,  INST_FUNCT_NONE, encode_instruction_I_branch  } },
 	{ INST_NAME_J,    { INST_OPCODE_J,    INST_FUNCT_NONE, encode_instruction_J_generic } },
 	{ INST_NAME_JR,   { INST_OPCODE_JR,   INST_FUNCT_JR,   encode_instruction_R_jr      } },
 	{ INST_NAME_JAL,  { INST_OPCODE_JAL,  INST_FUNCT_NONE, encode_instruction_J_generic } },
-};
+});
 
 //==============================================================================
 // Encoding Functions
 //==============================================================================
 
+/**
+ * @brief Looks up a token in a table.
+ *
+ * @param table Target table.
+ * @param token Target token.
+ * @param what  What is looked up, for error messages.
+ *
+ * @returns The matching entry.
+ */
+template<typename T, std::size_t N>
+static const T &lookup(const PerfectHash<T, N> &table, std::string_view token, const char *what)
+{
+	const T *value = table.find(token);
+
+	if (value == nullptr)
+		throw std::invalid_argument(what);
+
+	return (*value);
+}
+
+/**
+ * @brief Parses a number.
+ *
+ * @param token Target token.
+ *
+ * @returns The number.
+ */
+static isa32::word_t parse(std::string_view token)
+{
+	isa32::word_t value = 0;
+
+	if (!parseNumber(token, value))
+		throw std::invalid_argument("invalid immediate");
+
+	return (value);
+}
+
+/**
+ * @brief Parses a number or a reference to a symbol.
+ *
+ * @param token Target token.
+ * @param type  Relocation type of a reference.
+ * @param ref   Where to store the reference.
+ *
+ * @returns The number, or zero for a reference.
+ */
+static isa32::word_t parse(std::string_view token, unsigned type, Reference &ref)
+{
+	isa32::word_t value = 0;
+
+	if (parseNumber(token, value))
+		return (value);
+
+	if (!isSymbol(token))
+		throw std::invalid_argument("invalid operand");
+
+	ref.type = type;
+	ref.symbol = token;
+
+	return (0);
+}
+
 /**
  * @brief Encodes a R-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_R_generic(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_R_generic(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t rd = registers[tokens[1]];
-	isa32::word_t rs = registers[tokens[2]];
-	isa32::word_t rt = registers[tokens[3]];
+	isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rs = lookup(registers, tokens[2], "unknown register");
+	isa32::word_t rt = lookup(registers, tokens[3], "unknown register");
 	isa32::word_t funct = i.funct;
 
 	isa32::word_t inst = 0;
@@ -155,19 +226,21 @@ static isa32::word_t encode_instruction_R_generic(const std::vector<const char *
 /**
  * @brief Encodes a shift R-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_R_shift(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_R_shift(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t rd = registers[tokens[1]];
-	isa32::word_t rt = registers[tokens[2]];
-	isa32::word_t shamt = std::stoul(tokens[3]);
+	isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rt = lookup(registers, tokens[2], "unknown register");
+	isa32::word_t shamt = parse(tokens[3]);
 	isa32::word_t funct = i.funct;
 
 	isa32::word_t inst = 0;
@@ -183,18 +256,20 @@ static isa32::word_t encode_instruction_R_shift(const std::vector<const char *>
 /**
  * @brief Encodes a mult/div R-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_R_muldiv(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_R_muldiv(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t rs = registers[tokens[1]];
-	isa32::word_t rt = registers[tokens[2]];
+	isa32::word_t rs = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rt = lookup(registers, tokens[2], "unknown register");
 	isa32::word_t funct = i.funct;
 
 	isa32::word_t inst = 0;
@@ -209,17 +284,19 @@ static isa32::word_t encode_instruction_R_muldiv(const std::vector<const char *>
 /**
  * @brief Encodes jr R-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_R_jr(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_R_jr(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t rs = registers[tokens[1]];
+	isa32::word_t rs = lookup(registers, tokens[1], "unknown register");
 	isa32::word_t funct = i.funct;
 
 	isa32::word_t inst = 0;
@@ -233,19 +310,21 @@ static isa32::word_t encode_instruction_R_jr(const std::vector<const char *> &to
 /**
  * @brief Encodes an I-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_I_generic(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_I_generic(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t rt = registers[tokens[1]];
-	isa32::word_t rs = registers[tokens[2]];
-	isa32::word_t imm = strtoul(tokens[3], NULL, 10);
+	isa32::word_t rt = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rs = lookup(registers, tokens[2], "unknown register");
+	isa32::word_t imm = parse(tokens[3]);
 
 	isa32::word_t inst = 0;
 	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
@@ -256,22 +335,52 @@ static isa32::word_t encode_instruction_I_generic(const std::vector<const char *
 	return (inst);
 }
 
+/**
+ * @brief Encodes a lui I-type instruction.
+ *
+ * @param i      Instruction information.
+ * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
+ *
+ * @returns The encoded instruction.
+ */
+static isa32::word_t encode_instruction_I_lui(const Instruction &i, const Tokens &tokens, Reference &ref)
+{
+	((void) ref);
+
+	isa32::word_t opcode = i.opcode;
+	isa32::word_t rt = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t imm = parse(tokens[2]);
+
+	if (imm > INST_MASK_IMM)
+		throw std::range_error("immediate out of range");
+
+	isa32::word_t inst = 0;
+	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
+	inst |= (rt & INST_MASK_RT) << INST_SHIFT_RT;
+	inst |= (imm & INST_MASK_IMM) << INST_SHIFT_IMM;
+
+	return (inst);
+}
+
 /**
  * @brief Encodes a lw/sw I-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_I_ls(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_I_ls(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
+	((void) ref);
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t imm = strtoul(tokens[2], NULL, 10);
-	isa32::word_t rs = registers[tokens[3]];
-	isa32::word_t rd = registers[tokens[1]];
+	isa32::word_t imm = parse(tokens[2]);
+	isa32::word_t rs = lookup(registers, tokens[3], "unknown register");
+	isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
 
 	isa32::word_t inst = 0;
 	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
@@ -282,20 +391,46 @@ static isa32::word_t encode_instruction_I_ls(const std::vector<const char *> &to
 	return (inst);
 }
 
+/**
+ * @brief Encodes a beq/bne I-type instruction.
+ *
+ * @param i      Instruction information.
+ * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
+ *
+ * @returns The encoded instruction.
+ */
+static isa32::word_t encode_instruction_I_branch(const Instruction &i, const Tokens &tokens, Reference &ref)
+{
+	isa32::word_t opcode = i.opcode;
+	isa32::word_t rs = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rt = lookup(registers, tokens[2], "unknown register");
+	isa32::word_t imm = parse(tokens[3], RELOC_MIPS32_PC16, ref);
+
+	isa32::word_t inst = 0;
+	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
+	inst |= (rs & INST_MASK_RS) << INST_SHIFT_RS;
+	inst |= (rt & INST_MASK_RT) << INST_SHIFT_RT;
+	inst |= (imm & INST_MASK_IMM) << INST_SHIFT_IMM;
+
+	return (inst);
+}
+
 /**
  * @brief Encodes a J-type instruction.
  *
+ * @param i      Instruction information.
  * @param tokens Instruction tokens.
+ * @param ref    Where to store a reference to a symbol.
  *
  * @returns The encoded instruction.
  */
-static isa32::word_t encode_instruction_J_generic(const std::vector<const char *> &tokens)
+static isa32::word_t encode_instruction_J_generic(const Instruction &i, const Tokens &tokens, Reference &ref)
 {
 	// TODO: sanity check tokens.
 
-	Instruction i = instructions[tokens[0]];
 	isa32::word_t opcode = i.opcode;
-	isa32::word_t target = strtoul(tokens[1], NULL, 10);
+	isa32::word_t target = parse(tokens[1], RELOC_MIPS32_26, ref);
 
 	isa32::word_t inst = 0;
 	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
@@ -305,9 +440,411 @@ static isa32::word_t encode_instruction_J_generic(const std::vector<const char *
 }
 
 // Encodes an instruction.
-isa32::word_t Mips32Assembler::encode_instruction(const std::vector<const char *> &tokens)
+isa32::word_t Mips32Assembler::encode_instruction(const Tokens &tokens, Reference &ref) const
+{
+	const Instruction &i = lookup(instructions, tokens[0], "unknown instruction");
+
+	return (i.encode(i, tokens, ref));
+}
+
+//==============================================================================
+// Pseudo-Instructions
+//==============================================================================
+
+/**
+ * @brief Pseudo-instruction information.
+ */
+class Pseudo
+{
+	public:
+
+		isa32::word_t opcode; /**< Opcode of the branch, if any.       */
+		isa32::word_t funct;  /**< Function of the R-type, if any.     */
+		bool swap;            /**< Swap the source operands?           */
+		size_t(*expand)(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs);
+};
+
+/**
+ * @brief Builds a R-type instruction.
+ */
+static isa32::word_t makeR(isa32::word_t funct, isa32::word_t rd, isa32::word_t rs, isa32::word_t rt)
+{
+	isa32::word_t inst = 0;
+	inst |= (rs & INST_MASK_RS) << INST_SHIFT_RS;
+	inst |= (rt & INST_MASK_RT) << INST_SHIFT_RT;
+	inst |= (rd & INST_MASK_RD) << INST_SHIFT_RD;
+	inst |= (funct & INST_MASK_FUNCT) << INST_SHIFT_FUNCT;
+
+	return (inst);
+}
+
+/**
+ * @brief Builds an I-type instruction.
+ */
+static isa32::word_t makeI(isa32::word_t opcode, isa32::word_t rt, isa32::word_t rs, isa32::word_t imm)
+{
+	isa32::word_t inst = 0;
+	inst |= (opcode & INST_MASK_OPCODE) << INST_SHIFT_OPCODE;
+	inst |= (rt & INST_MASK_RT) << INST_SHIFT_RT;
+	inst |= (rs & INST_MASK_RS) << INST_SHIFT_RS;
+	inst |= (imm & INST_MASK_IMM) << INST_SHIFT_IMM;
+
+	return (inst);
+}
+
+/**
+ * @brief Loads a constant with the fewest instructions.
+ *
+ * @param rt    Target register.
+ * @param value Target constant.
+ * @param words Where to store the instructions.
+ *
+ * @returns The number of instructions.
+ */
+static size_t loadConstant(isa32::word_t rt, isa32::word_t value, isa32::word_t *words)
+{
+	int32_t imm = static_cast<int32_t>(value);
+
+	// Sign-extended 16 bits.
+	if ((imm >= -32768) && (imm <= 32767))
+	{
+		words[0] = makeI(INST_OPCODE_ADDI, rt, REG_ZERO, value);
+		return (1);
+	}
+
+	// Zero-extended 16 bits.
+	if (value <= INST_MASK_IMM)
+	{
+		words[0] = makeI(INST_OPCODE_ORI, rt, REG_ZERO, value);
+		return (1);
+	}
+
+	words[0] = makeI(INST_OPCODE_LUI, rt, REG_ZERO, value >> 16);
+	if ((value & INST_MASK_IMM) == 0)
+		return (1);
+
+	words[1] = makeI(INST_OPCODE_ORI, rt, rt, value & INST_MASK_IMM);
+
+	return (2);
+}
+
+/**
+ * @brief Expands nop (sll zero, zero, 0).
+ */
+static size_t expand_nop(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	((void) p);
+	((void) tokens);
+	((void) refs);
+
+	words[0] = makeR(INST_FUNCT_SLL, REG_ZERO, REG_ZERO, REG_ZERO);
+
+	return (1);
+}
+
+/**
+ * @brief Expands move, not and neg (rd, rs) into a R-type with zero.
+ */
+static size_t expand_R_zero(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
 {
-	Instruction i = instructions[tokens[0]];
+	((void) refs);
+
+	isa32::word_t rd = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rs = lookup(registers, tokens[2], "unknown register");
+
+	words[0] = p.swap ? makeR(p.funct, rd, REG_ZERO, rs) : makeR(p.funct, rd, rs, REG_ZERO);
+
+	return (1);
+}
 
-	return (i.encode(tokens));
-}
\ No newline at end of file
+/**
+ * @brief Expands li (rt, imm).
+ */
+static size_t expand_li(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	((void) p);
+	((void) refs);
+
+	isa32::word_t rt = lookup(registers, tokens[1], "unknown register");
+
+	return (loadConstant(rt, parse(tokens[2]), words));
+}
+
+/**
+ * @brief Expands la (rt, symbol).
+ */
+static size_t expand_la(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	((void) p);
+
+	isa32::word_t rt = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t value = 0;
+
+	if (parseNumber(tokens[2], value))
+		return (loadConstant(rt, value, words));
+
+	// The address is only known once linked.
+	words[0] = makeI(INST_OPCODE_LUI, rt, REG_ZERO, parse(tokens[2], RELOC_MIPS32_HI16, refs[0]));
+	words[1] = makeI(INST_OPCODE_ORI, rt, rt, parse(tokens[2], RELOC_MIPS32_LO16, refs[1]));
+
+	return (2);
+}
+
+/**
+ * @brief Expands b (target).
+ */
+static size_t expand_b(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	words[0] = makeI(p.opcode, REG_ZERO, REG_ZERO, parse(tokens[1], RELOC_MIPS32_PC16, refs[0]));
+
+	return (1);
+}
+
+/**
+ * @brief Expands beqz and bnez (rs, target).
+ */
+static size_t expand_B_zero(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	isa32::word_t rs = lookup(registers, tokens[1], "unknown register");
+
+	words[0] = makeI(p.opcode, REG_ZERO, rs, parse(tokens[2], RELOC_MIPS32_PC16, refs[0]));
+
+	return (1);
+}
+
+/**
+ * @brief Expands blt, bge, bgt and ble (rs, rt, target) into a slt
+ * on $at and a branch on $at.
+ */
+static size_t expand_B_compare(const Pseudo &p, const Tokens &tokens, isa32::word_t *words, Reference *refs)
+{
+	isa32::word_t rs = lookup(registers, tokens[1], "unknown register");
+	isa32::word_t rt = lookup(registers, tokens[2], "unknown register");
+
+	words[0] = p.swap ? makeR(INST_FUNCT_SLT, REG_AT, rt, rs) : makeR(INST_FUNCT_SLT, REG_AT, rs, rt);
+	words[1] = makeI(p.opcode, REG_ZERO, REG_AT, parse(tokens[3], RELOC_MIPS32_PC16, refs[1]));
+
+	return (2);
+}
+
+// Map of Pseudo-Instructions
+static constexpr auto pseudos = makePerfectHash<Pseudo>({
+	{ INST_NAME_NOP,  { INST_OPCODE_NONE, INST_FUNCT_NONE, false, expand_nop       } },
+	{ INST_NAME_MOVE, { INST_OPCODE_NONE, INST_FUNCT_ADD,  false, expand_R_zero    } },
+	{ INST_NAME_NOT,  { INST_OPCODE_NONE, INST_FUNCT_NOR,  false, expand_R_zero    } },
+	{ INST_NAME_NEG,  { INST_OPCODE_NONE, INST_FUNCT_SUB,  true,  expand_R_zero    } },
+	{ INST_NAME_LI,   { INST_OPCODE_NONE, INST_FUNCT_NONE, false, expand_li        } },
+	{ INST_NAME_LA,   { INST_OPCODE_NONE, INST_FUNCT_NONE, false, expand_la        } },
+	{ INST_NAME_B,    { INST_OPCODE_BEQ,  INST_FUNCT_NONE, false, expand_b         } },
+	{ INST_NAME_BEQZ, { INST_OPCODE_BEQ,  INST_FUNCT_NONE, false, expand_B_zero    } },
+	{ INST_NAME_BNEZ, { INST_OPCODE_BNE,  INST_FUNCT_NONE, false, expand_B_zero    } },
+	{ INST_NAME_BLT,  { INST_OPCODE_BNE,  INST_FUNCT_NONE, false, expand_B_compare } },
+	{ INST_NAME_BGE,  { INST_OPCODE_BEQ,  INST_FUNCT_NONE, false, expand_B_compare } },
+	{ INST_NAME_BGT,  { INST_OPCODE_BNE,  INST_FUNCT_NONE, true,  expand_B_compare } },
+	{ INST_NAME_BLE,  { INST_OPCODE_BEQ,  INST_FUNCT_NONE, true,  expand_B_compare } },
+});
+
+// Encodes an instruction or a pseudo-instruction.
+size_t Mips32Assembler::expand_instruction(const Tokens &tokens, isa32::word_t *words, Reference *refs) const
+{
+	const Pseudo *p = pseudos.find(tokens[0]);
+
+	if (p == nullptr)
+		return (Assembler::expand_instruction(tokens, words, refs));
+
+	return (p->expand(*p, tokens, words, refs));
+}
+
+// Gets the name of the assembled language.
+const char *Mips32Assembler::name(void) const
+{
+	return ("mips32");
+}
+
+// Patches an instruction with the address of a symbol.
+isa32::word_t Mips32Assembler::relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const
+{
+	switch (type)
+	{
+		// Offset in words from the delay slot.
+		case RELOC_MIPS32_PC16:
+		{
+			int32_t offset = static_cast<int32_t>(value - (pc + 4))/4;
+
+			if ((offset < -32768) || (offset > 32767))
+				throw std::range_error("branch out of range");
+
+			return (word | ((offset & INST_MASK_IMM) << INST_SHIFT_IMM));
+		}
+
+		// Word address within the region of the delay slot.
+		case RELOC_MIPS32_26:
+			if (((pc + 4) ^ value) & 0xf0000000)
+				throw std::range_error("jump out of range");
+
+			return (word | (((value >> 2) & INST_MASK_TARGET) << INST_SHIFT_TARGET));
+
+		// Halves of the address, for lui and a zero-extending ori.
+		case RELOC_MIPS32_HI16:
+			return (word | (((value >> 16) & INST_MASK_IMM) << INST_SHIFT_IMM));
+
+		case RELOC_MIPS32_LO16:
+			return (word | ((value & INST_MASK_IMM) << INST_SHIFT_IMM));
+
+		default:
+			return (Assembler::relocate(word, type, pc, value));
+	}
+}
+//==============================================================================
+// Disassembly Tables
+//==============================================================================
+
+namespace
+{
+	/**
+	 * @brief Operand formats.
+	 */
+	enum Format : uint8_t
+	{
+		FORMAT_NONE,   /**< Not an instruction.   */
+		FORMAT_R,      /**< rd, rs, rt            */
+		FORMAT_SHIFT,  /**< rd, rt, shamt         */
+		FORMAT_MULDIV, /**< rs, rt                */
+		FORMAT_JR,     /**< rs                    */
+		FORMAT_I,      /**< rt, rs, imm           */
+		FORMAT_IU,     /**< rt, rs, unsigned imm  */
+		FORMAT_LUI,    /**< rt, unsigned imm      */
+		FORMAT_LS,     /**< rt, imm(rs)           */
+		FORMAT_BRANCH, /**< rs, rt, offset        */
+		FORMAT_J,      /**< target                */
+	};
+
+	/**
+	 * @brief Decoding information of an opcode or a function.
+	 */
+	struct Decoding
+	{
+		Format format;    /**< Operand format. */
+		const char *name; /**< Name.           */
+	};
+}
+
+// Names of registers, by number.
+static constexpr std::string_view registerNames[32] = {
+	REG_NAME_ZERO, REG_NAME_AT, REG_NAME_V0, REG_NAME_V1,
+	REG_NAME_A0,   REG_NAME_A1, REG_NAME_A2, REG_NAME_A3,
+	REG_NAME_T0,   REG_NAME_T1, REG_NAME_T2, REG_NAME_T3,
+	REG_NAME_T4,   REG_NAME_T5, REG_NAME_T6, REG_NAME_T7,
+	REG_NAME_S0,   REG_NAME_S1, REG_NAME_S2, REG_NAME_S3,
+	REG_NAME_S4,   REG_NAME_S5, REG_NAME_S6, REG_NAME_S7,
+	REG_NAME_T8,   REG_NAME_T9, REG_NAME_K0, REG_NAME_K1,
+	REG_NAME_GP,   REG_NAME_SP, REG_NAME_FP, REG_NAME_RA,
+};
+
+// Opcodes other than R-type.
+static constexpr std::array<Decoding, 64> opcodes = []() {
+	std::array<Decoding, 64> t = {};
+	t[INST_OPCODE_ADDI] = { FORMAT_I,      INST_NAME_ADDI };
+	t[INST_OPCODE_ANDI] = { FORMAT_IU,     INST_NAME_ANDI };
+	t[INST_OPCODE_ORI]  = { FORMAT_IU,     INST_NAME_ORI  };
+	t[INST_OPCODE_LUI]  = { FORMAT_LUI,    INST_NAME_LUI  };
+	t[INST_OPCODE_SLTI] = { FORMAT_I,      INST_NAME_SLTI };
+	t[INST_OPCODE_LW]   = { FORMAT_LS,     INST_NAME_LW   };
+	t[INST_OPCODE_SW]   = { FORMAT_LS,     INST_NAME_SW   };
+	t[INST_OPCODE_BEQ]  = { FORMAT_BRANCH, INST_NAME_BEQ  };
+	t[INST_OPCODE_BNE]  = { FORMAT_BRANCH, INST_NAME_BNE  };
+	t[INST_OPCODE_J]    = { FORMAT_J,      INST_NAME_J    };
+	t[INST_OPCODE_JAL]  = { FORMAT_J,      INST_NAME_JAL  };
+	return (t);
+}();
+
+// Functions of R-type instructions.
+static constexpr std::array<Decoding, 64> functs = []() {
+	std::array<Decoding, 64> t = {};
+	t[INST_FUNCT_ADD]   = { FORMAT_R,      INST_NAME_ADD  };
+	t[INST_FUNCT_ADDU]  = { FORMAT_R,      "addu"         };
+	t[INST_FUNCT_SUB]   = { FORMAT_R,      INST_NAME_SUB  };
+	t[INST_FUNCT_SUBU]  = { FORMAT_R,      "subu"         };
+	t[INST_FUNCT_MULT]  = { FORMAT_MULDIV, INST_NAME_MULT };
+	t[INST_FUNCT_MULTU] = { FORMAT_MULDIV, "multu"        };
+	t[INST_FUNCT_DIV]   = { FORMAT_MULDIV, INST_NAME_DIV  };
+	t[INST_FUNCT_DIVU]  = { FORMAT_MULDIV, "divu"         };
+	t[INST_FUNCT_AND]   = { FORMAT_R,      INST_NAME_AND  };
+	t[INST_FUNCT_OR]    = { FORMAT_R,      INST_NAME_OR   };
+	t[INST_FUNCT_XOR]   = { FORMAT_R,      INST_NAME_XOR  };
+	t[INST_FUNCT_NOR]   = { FORMAT_R,      INST_NAME_NOR  };
+	t[INST_FUNCT_SLT]   = { FORMAT_R,      INST_NAME_SLT  };
+	t[INST_FUNCT_SLTU]  = { FORMAT_R,      "sltu"         };
+	t[INST_FUNCT_SLL]   = { FORMAT_SHIFT,  INST_NAME_SLL  };
+	t[INST_FUNCT_SRL]   = { FORMAT_SHIFT,  INST_NAME_SRL  };
+	t[INST_FUNCT_SRA]   = { FORMAT_SHIFT,  "sra"          };
+	t[INST_FUNCT_JR]    = { FORMAT_JR,     INST_NAME_JR   };
+	return (t);
+}();
+
+//==============================================================================
+// Disassembly
+//==============================================================================
+
+// Formats an instruction.
+void Mips32Disassembler::format(isa32::word_t inst, TextBuffer &out) const
+{
+	isa32::word_t opcode = (inst >> INST_SHIFT_OPCODE) & INST_MASK_OPCODE;
+	const Decoding &d = (opcode == 0) ? functs[(inst >> INST_SHIFT_FUNCT) & INST_MASK_FUNCT] : opcodes[opcode];
+	std::string_view rs = registerNames[(inst >> INST_SHIFT_RS) & INST_MASK_RS];
+	std::string_view rt = registerNames[(inst >> INST_SHIFT_RT) & INST_MASK_RT];
+	std::string_view rd = registerNames[(inst >> INST_SHIFT_RD) & INST_MASK_RD];
+	int32_t imm = static_cast<int16_t>(inst & INST_MASK_IMM);
+
+	if (d.format == FORMAT_NONE)
+	{
+		out.put(".word ");
+		out.putHex(inst);
+		return;
+	}
+
+	out.put(d.name);
+	switch (d.format)
+	{
+		case FORMAT_R:
+			out.put(' ', rd, ", ", rs, ", ", rt);
+		break;
+		case FORMAT_SHIFT:
+			out.put(' ', rd, ", ", rt, ", ");
+			out.putDecimal((inst >> INST_SHIFT_SHAMT) & INST_MASK_SHAMT);
+		break;
+		case FORMAT_MULDIV:
+			out.put(' ', rs, ", ", rt);
+		break;
+		case FORMAT_JR:
+			out.put(' ', rs);
+		break;
+		case FORMAT_I:
+			out.put(' ', rt, ", ", rs, ", ");
+			out.putDecimal(imm);
+		break;
+		case FORMAT_IU:
+			out.put(' ', rt, ", ", rs, ", ");
+			out.putHex(inst & INST_MASK_IMM);
+		break;
+		case FORMAT_LUI:
+			out.put(' ', rt, ", ");
+			out.putHex(inst & INST_MASK_IMM);
+		break;
+		case FORMAT_LS:
+			out.put(' ', rt, ", ");
+			out.putDecimal(imm);
+			out.put('(', rs, ')');
+		break;
+		case FORMAT_BRANCH:
+			out.put(' ', rs, ", ", rt, ", ");
+			out.putDecimal(imm);
+		break;
+		case FORMAT_J:
+			out.put(' ');
+			out.putDecimal((inst >> INST_SHIFT_TARGET) & INST_MASK_TARGET);
+		break;
+		default:
+		break;
+	}
+}
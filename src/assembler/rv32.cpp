@@ -0,0 +1,237 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// Ours
+#include <asm/rv32.h>
+#include <vmachine/isa.h>
+#include <perfecthash.h>
+
+using namespace rv32;
+
+// Encodes an instruction.
+isa32::word_t Rv32Assembler::encode_instruction(const Tokens &tokens, Reference &ref) const
+{
+	return (Encoding::encode(tokens, ref));
+}
+
+// Gets the name of the assembled language.
+const char *Rv32Assembler::name(void) const
+{
+	return ("rv32");
+}
+
+// Patches an instruction with the address of a symbol.
+isa32::word_t Rv32Assembler::relocate(isa32::word_t word, unsigned type, isa32::word_t pc, isa32::word_t value) const
+{
+	return (Encoding::relocate(word, type, pc, value));
+}
+
+//==============================================================================
+// Disassembly Tables
+//==============================================================================
+
+namespace
+{
+	/**
+	 * @brief Operand formats.
+	 */
+	enum Format : uint8_t
+	{
+		FORMAT_NONE,   /**< Not an instruction.      */
+		FORMAT_R,      /**< rd, rs1, rs2             */
+		FORMAT_I,      /**< rd, rs1, imm or shamt    */
+		FORMAT_LOAD,   /**< rd, imm(rs1)             */
+		FORMAT_STORE,  /**< rs2, imm(rs1)            */
+		FORMAT_BRANCH, /**< rs1, rs2, offset         */
+		FORMAT_U,      /**< rd, imm                  */
+		FORMAT_JAL,    /**< rd, offset               */
+		FORMAT_FIXED,  /**< No operands.             */
+	};
+
+	/**
+	 * @brief Decoding information of a major opcode.
+	 */
+	struct Opcode
+	{
+		Format format;             /**< Operand format.              */
+		const char *name;          /**< Name, if fixed.              */
+		const char *const *names;  /**< Names by funct3, otherwise.  */
+	};
+}
+
+// ABI names of registers.
+static constexpr std::string_view registerNames[32] = {
+	"zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+	"s0",   "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+	"a6",   "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+	"s8",   "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+// Names by funct3.
+static constexpr const char *namesOp[8]     = { "add", "sll", "slt", "sltu", "xor", "srl", "or", "and" };
+static constexpr const char *namesOpAlt[8]  = { "sub", nullptr, nullptr, nullptr, nullptr, "sra", nullptr, nullptr };
+static constexpr const char *namesOpImm[8]  = { "addi", "slli", "slti", "sltiu", "xori", "srli", "ori", "andi" };
+static constexpr const char *namesLoad[8]   = { "lb", "lh", "lw", nullptr, "lbu", "lhu", nullptr, nullptr };
+static constexpr const char *namesStore[8]  = { "sb", "sh", "sw", nullptr, nullptr, nullptr, nullptr, nullptr };
+static constexpr const char *namesBranch[8] = { "beq", "bne", nullptr, nullptr, "blt", "bge", "bltu", "bgeu" };
+static constexpr const char *namesJalr[8]   = { "jalr", nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+
+// Major opcodes, by bits 6:2.
+static constexpr Opcode opcodes[32] = {
+	{ FORMAT_LOAD,   nullptr, namesLoad   }, // 0x03
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_FIXED,  "fence", nullptr     }, // 0x0f
+	{ FORMAT_I,      nullptr, namesOpImm  }, // 0x13
+	{ FORMAT_U,      "auipc", nullptr     }, // 0x17
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_STORE,  nullptr, namesStore  }, // 0x23
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_R,      nullptr, namesOp     }, // 0x33
+	{ FORMAT_U,      "lui",   nullptr     }, // 0x37
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_BRANCH, nullptr, namesBranch }, // 0x63
+	{ FORMAT_LOAD,   nullptr, namesJalr   }, // 0x67
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_JAL,    "jal",   nullptr     }, // 0x6f
+	{ FORMAT_FIXED,  nullptr, nullptr     }, // 0x73
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+	{ FORMAT_NONE,   nullptr, nullptr     },
+};
+
+//==============================================================================
+// Disassembly
+//==============================================================================
+
+// Formats an instruction.
+void Rv32Disassembler::format(isa32::word_t inst, TextBuffer &out) const
+{
+	constexpr isa32::word_t fence = instructions.find("fence")->bits;
+	constexpr isa32::word_t ecall = instructions.find("ecall")->bits;
+	constexpr isa32::word_t ebreak = instructions.find("ebreak")->bits;
+	const Opcode &op = opcodes[(inst >> 2) & 0x1f];
+	unsigned funct_3 = (inst >> INST_SHIFT_FUNCT_3) & INST_MASK_FUNCT_3;
+	unsigned funct_7 = (inst >> INST_SHIFT_FUNCT_7) & INST_MASK_FUNCT_7;
+	std::string_view rd = registerNames[(inst >> INST_SHIFT_RD) & INST_MASK_RD];
+	std::string_view rs1 = registerNames[(inst >> INST_SHIFT_RS_1) & INST_MASK_RS_1];
+	std::string_view rs2 = registerNames[(inst >> INST_SHIFT_RS_2) & INST_MASK_RS_2];
+	int32_t imm = static_cast<int32_t>(inst) >> INST_SHIFT_IMMEDIATE_I_TYPE;
+	const char *name = (op.names != nullptr) ? op.names[funct_3] : op.name;
+
+	// Fields that select among instructions.
+	switch (op.format)
+	{
+		case FORMAT_R:
+			if (funct_7 == INST_SUB_FUNCT_7)
+				name = namesOpAlt[funct_3];
+			else if (funct_7 != 0)
+				name = nullptr;
+		break;
+		case FORMAT_I:
+			if (funct_3 == INST_SRAI_FUNCT_3)
+				name = (funct_7 == INST_SRA_FUNCT_7) ? "srai" : ((funct_7 == 0) ? name : nullptr);
+			else if ((funct_3 == INST_SLLI_FUNCT_3) && (funct_7 != 0))
+				name = nullptr;
+		break;
+		case FORMAT_FIXED:
+			name = (inst == fence)  ? "fence"  :
+			       (inst == ecall)  ? "ecall"  :
+			       (inst == ebreak) ? "ebreak" : nullptr;
+		break;
+		default:
+		break;
+	}
+
+	if (((inst & 3) != 3) || (op.format == FORMAT_NONE) || (name == nullptr))
+	{
+		out.put(".word ");
+		out.putHex(inst);
+		return;
+	}
+
+	out.put(name);
+	switch (op.format)
+	{
+		case FORMAT_R:
+			out.put(' ', rd, ", ", rs1, ", ", rs2);
+		break;
+		case FORMAT_I:
+			out.put(' ', rd, ", ", rs1, ", ");
+			out.putDecimal(((funct_3 == INST_SLLI_FUNCT_3) || (funct_3 == INST_SRLI_FUNCT_3)) ? (imm & 0x1f) : imm);
+		break;
+		case FORMAT_LOAD:
+			out.put(' ', rd, ", ");
+			out.putDecimal(imm);
+			out.put('(', rs1, ')');
+		break;
+		case FORMAT_STORE:
+			out.put(' ', rs2, ", ");
+			out.putDecimal((imm & ~0x1f) | ((inst >> INST_SHIFT_RD) & 0x1f));
+			out.put('(', rs1, ')');
+		break;
+		case FORMAT_BRANCH:
+			out.put(' ', rs1, ", ", rs2, ", ");
+			out.putDecimal(
+				((static_cast<int32_t>(inst) >> 31) << 12) |
+				(((inst >> 7) & 0x01) << 11)               |
+				(((inst >> 25) & 0x3f) << 5)               |
+				(((inst >> 8) & 0x0f) << 1)
+			);
+		break;
+		case FORMAT_U:
+			out.put(' ', rd, ", ");
+			out.putHex(inst >> INST_SHIFT_IMMEDIATE);
+		break;
+		case FORMAT_JAL:
+			out.put(' ', rd, ", ");
+			out.putDecimal(
+				((static_cast<int32_t>(inst) >> 31) << 20) |
+				(((inst >> 12) & 0xff) << 12)              |
+				(((inst >> 20) & 0x01) << 11)              |
+				(((inst >> 21) & 0x3ff) << 1)
+			);
+		break;
+		default:
+		break;
+	}
+}
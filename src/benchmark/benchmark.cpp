@@ -34,45 +34,7 @@
 //#include "../vmachine/core.cpp"
 
 // Instructions Array
-isa32::word_t instructions[INSTRUCTIONS_NUMS] = {
-    ADD,
-    SUB,
-    SLL,
-    SLT,
-    SLTU,
-    XOR,
-    SRL,
-    SRA,
-    OR,
-    AND,
-    JALR,
-    LB,
-    LH,
-    LW,
-    LBU,
-    LHU,
-    ADDI,
-    SLTI,
-    SLTIU,
-    XORI,
-    PRI,
-    ANDI,
-    SLLI,
-    SRLI,
-    SRAI,
-    LUI,
-    AUIPC,
-    JAL,
-    SB,
-    SH,
-    SW,
-    BEQ,
-    BNE,
-    BLT,
-    BGE,
-    BLTU,
-    BGEU
-};
+using instructions_bank::instructions;
 
 // Get how many times each type was executed
 int r_type_quantity;
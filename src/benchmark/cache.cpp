@@ -0,0 +1,112 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+
+#include <vmachine/cache.h>
+
+/**
+ * @brief Size of the simulated last-level cache (in bytes).
+ */
+#define LLC_SIZE (1024*1024)
+
+/**
+ * @brief Size of a line of the simulated last-level cache (in bytes).
+ */
+#define LLC_LINE_SIZE 64
+
+/**
+ * @brief Number of lookups per run.
+ */
+#define LOOKUPS_NUMS (1 << 22)
+
+// Names of tag lookup implementations.
+static const char *impl_names[] = { "scalar", "sse2", "avx2" };
+
+// Measures lookups per second for a given geometry.
+static double run(unsigned ways, const std::vector<unsigned> &addrs, unsigned long &hits)
+{
+	Cache llc(LLC_SIZE, ways, LLC_LINE_SIZE);
+
+	// Warm up.
+	for (unsigned addr : addrs)
+		llc.access(addr);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (unsigned addr : addrs)
+		hits += llc.access(addr);
+
+	auto end = std::chrono::high_resolution_clock::now() - start;
+
+	double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end).count();
+
+	return (addrs.size()/seconds);
+}
+
+int main()
+{
+	std::vector<unsigned> addrs(LOOKUPS_NUMS);
+	Cache::LookupImpl impls[] = {
+		Cache::LOOKUP_SCALAR, Cache::LOOKUP_SSE2, Cache::LOOKUP_AVX2
+	};
+	unsigned long hits = 0;
+
+	// Random accesses over twice the size of the cache.
+	for (auto &addr : addrs)
+		addr = (rand() % (2*LLC_SIZE)) & ~3u;
+
+	std::cout << "LLC: " << LLC_SIZE/1024 << " KB, " << LLC_LINE_SIZE << " B lines\n\n";
+	std::cout << std::setw(6) << "ways";
+	for (auto impl : impls)
+		std::cout << std::setw(14) << impl_names[impl];
+	std::cout << "   (million lookups/s)\n";
+
+	for (unsigned ways = 1; ways <= Cache::MAX_WAYS; ways *= 2)
+	{
+		std::cout << std::setw(6) << ways;
+
+		for (auto impl : impls)
+		{
+			if (!Cache::setLookupImpl(impl))
+			{
+				std::cout << std::setw(14) << "-";
+				continue;
+			}
+
+			std::cout << std::setw(14) << std::fixed << std::setprecision(1)
+				<< run(ways, addrs, hits)/1e6;
+		}
+
+		std::cout << "\n";
+	}
+
+	std::cout << "\nTotal hits: " << hits << "\n";
+
+	return (0);
+}
@@ -25,65 +25,103 @@
 #ifndef BENCHMARCK_INSTRUCTIONS_BANK_H_
 #define BENCHMARCK_INSTRUCTIONS_BANK_H_
 
+// Ours
+#include <asm/rv32.h>
+
 namespace instructions_bank
 {
-    #define INSTRUCTIONS_NUMS 37
-
-    /**
-	 * @name Instructions examples bank
+	/**
+	 * @brief Instructions examples bank
+	 *
+	 * @details One of each RV32I instruction, encoded by the compiler.
 	 */
-	/**@{*/
- 
-    // R-Type
-    #define ADD   0x718033
-    #define SUB   0x40408033
-    #define SLL   0x5114b3
-    #define SLT   0x122433
-    #define SLTU  0x643233
-    #define XOR   0x33c0b3
-    #define SRL   0x5353b3
-    #define SRA   0x4082d4b3
-    #define OR    0x91e333
-    #define AND   0xa0f5b3
+	inline constexpr auto instructions = RV32_ASSEMBLE(
+		// R-Type
+		"add   zero, gp, t2\n"
+		"sub   zero, ra, tp\n"
+		"sll   s1, sp, t0\n"
+		"slt   s0, tp, ra\n"
+		"sltu  tp, s0, t1\n"
+		"xor   ra, t2, gp\n"
+		"srl   t2, t1, t0\n"
+		"sra   s1, t0, s0\n"
+		"or    t1, gp, s1\n"
+		"and   a1, ra, a0\n"
+
+		// I-Type (the first word was always a jal, despite its slot)
+		"jal   tp, 167588\n"
+		"lb    sp, 1925(ra)\n"
+		"lh    ra, 340(zero)\n"
+		"lw    gp, 1629(a3)\n"
+		"lbu   t0, 1381(t2)\n"
+		"lhu   t2, 681(s1)\n"
+		"addi  zero, a1, -1751\n"
+		"slti  ra, sp, 1365\n"
+		"sltiu gp, ra, -235\n"
+		"xori  s1, gp, 459\n"
+		"ori   tp, t2, 1707\n"
+		"andi  t1, tp, -299\n"
+		"slli  gp, zero, 1\n"
+		"srli  t0, tp, 3\n"
+		"srai  t2, t1, 4\n"
+
+		// U-Type
+		"lui   tp, 0xaaf1d\n"
+		"auipc ra, 0xcd7e6\n"
+
+		// J-Type
+		"jal   zero, -879458\n"
 
-    // I-Type
-    #define JALR  0x6a52826f
-    #define LB    0x78508103
-    #define LH    0x15401083
-    #define LW    0x65d6a183
-    #define LBU   0x5653c283
-    #define LHU   0x2a94d383
-    #define ADDI  0x92958013
-    #define SLTI  0x55512093
-    #define SLTIU 0xf150b193
-    #define XORI  0x1cb1c493
-    #define PRI   0x6ab3e213
-    #define ANDI  0xed527313
-    #define SLLI  0x101193
-    #define SRLI  0x325293
-    #define SRAI  0x40435393
+		// S-type
+		"sb    sp, -1710(ra)\n"
+		"sh    gp, -1099(t2)\n"
+		"sw    t0, -1159(s1)\n"
 
-    // U-Type
-    #define LUI   0xaaf1d237
-    #define AUIPC 0xcd7e6097
+		// B-Type
+		"beq   tp, zero, 850\n"
+		"bne   gp, ra, -1576\n"
+		"blt   ra, sp, 1284\n"
+		"bge   t2, gp, -1764\n"
+		"bltu  s0, t0, 2870\n"
+		"bgeu  gp, t1, 1368\n"
+	);
+
+	/**
+	 * @brief Words of the bank, as once written by hand.
+	 */
+	inline constexpr isa32::word_t encodings[] = {
+		0x00718033, 0x40408033, 0x005114b3, 0x00122433, 0x00643233,
+		0x0033c0b3, 0x005353b3, 0x4082d4b3, 0x0091e333, 0x00a0f5b3,
+		0x6a52826f, 0x78508103, 0x15401083, 0x65d6a183, 0x5653c283,
+		0x2a94d383, 0x92958013, 0x55512093, 0xf150b193, 0x1cb1c493,
+		0x6ab3e213, 0xed527313, 0x00101193, 0x00325293, 0x40435393,
+		0xaaf1d237, 0xcd7e6097,
+		0xc9e2906f,
+		0x94208923, 0xba339aa3, 0xb654aca3,
+		0x34020963, 0x9c119ce3, 0x5020c263, 0x9033dee3, 0x32546be3,
+		0x5461fc63,
+	};
+
+	/**
+	 * @brief Asserts that the bank assembles into the words written by hand.
+	 */
+	constexpr bool matches(void)
+	{
+		if (instructions.size() != (sizeof(encodings)/sizeof(encodings[0])))
+			return (false);
 
-    // J-Type
-    #define JAL   0xc9e2906f
+		for (size_t i = 0; i < instructions.size(); i++)
+		{
+			if (instructions[i] != encodings[i])
+				return (false);
+		}
 
-    // S-type
-    #define SB    0x94208923
-    #define SH    0xba339aa3
-    #define SW    0xb654aca3
+		return (true);
+	}
 
-    // B-Type
-    #define BEQ   0x34020963
-    #define BNE   0x9c119ce3
-    #define BLT   0x5020c263
-    #define BGE   0x9033dee3
-    #define BLTU  0x32546be3
-    #define BGEU  0x5461fc63
+	static_assert(matches(), "instruction bank does not match its encodings");
 
-    /**@}*/
+	#define INSTRUCTIONS_NUMS (instructions_bank::instructions.size())
 }
 
-#endif // BENCHMARCK_INSTRUCTIONS_BANK_H_
\ No newline at end of file
+#endif // BENCHMARCK_INSTRUCTIONS_BANK_H_
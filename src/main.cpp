@@ -23,18 +23,63 @@
 //
 
 // Theirs
+#include <cstring>
+#include <elf.h>
 #include <fstream>
 #include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
 
 // Ours
 #include <vmachine.h>
+#include <vmachine/image.h>
 #include <config.h>
 
 // Import definitions.
 extern void testDriver(void);
 
-int main()
+// Converts an ELF executable or an assembly file into a native image
+// or an ELF executable.
+static int mkimg(const std::string &input, const std::string &output, bool elf)
 {
+	char magic[SELFMAG] = { 0 };
+
+	std::ifstream(input, std::ios::binary).read(magic, SELFMAG);
+
+	try
+	{
+		vmachine::Image img = (memcmp(magic, ELFMAG, SELFMAG) == 0) ?
+			vmachine::Image::fromElf(input) : vmachine::Image::fromAsm(input);
+
+		if (elf)
+			img.writeElf(output);
+		else
+			img.write(output);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "mkimg: " << e.what() << std::endl;
+		return (1);
+	}
+
+	return (0);
+}
+
+int main(int argc, char **argv)
+{
+	// vmachine mkimg|mkelf <input> <output>
+	if (argc > 1)
+	{
+		if ((argc == 4) && (std::string(argv[1]) == "mkimg"))
+			return (mkimg(argv[2], argv[3], false));
+		if ((argc == 4) && (std::string(argv[1]) == "mkelf"))
+			return (mkimg(argv[2], argv[3], true));
+
+		std::cerr << "usage: " << argv[0] << " [mkimg|mkelf <input> <output>]" << std::endl;
+		return (1);
+	}
+
 	testDriver();
 
 	return (0);
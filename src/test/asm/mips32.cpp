@@ -23,12 +23,19 @@
 //
 
 // Theirs
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <list>
+#include <thread>
+#include <vector>
 
 // Ours
 #include <asm/mips32.h>
 #include <arch/mips32.h>
+#include <perfecthash.h>
+#include <threadpool.h>
 #include <test.h>
 
 using namespace mips32;
@@ -203,6 +210,477 @@ bool test_encode_j_generic(void)
 	return (assertEquals(want, have));
 }
 
+bool test_assembly_stream(void)
+{
+	Mips32Assembler a;
+	std::string add = "add s0, s1, s2";
+	std::string sub = "sub t0, t1, t2";
+	isa32::word_t addw = a.assembly(add);
+	isa32::word_t subw = a.assembly(sub);
+	std::stringstream source;
+	std::vector<isa32::word_t> words;
+	const unsigned lines = ASSEMBLER_CHUNK_SIZE/8;
+	unsigned chunks = 0;
+	bool ok = true;
+
+	// Spans several chunks, with blank lines and no final newline.
+	for (unsigned i = 0; i < lines; i++)
+		source << ((i & 1) ? sub : add) << "\n\n";
+	source << add;
+
+	a.assembly(source, [&](const isa32::word_t *w, size_t count) {
+		words.insert(words.end(), w, w + count);
+		chunks++;
+	});
+
+	for (unsigned i = 0; i < lines; i++)
+		ok = ok && (words[i] == ((i & 1) ? subw : addw));
+
+	return (
+		ok                                    &&
+		(chunks > 1)                          &&
+		assertEquals(words.size(), lines + 1) &&
+		assertEquals(words.back(), addw)
+	);
+}
+
+bool test_tokenize(void)
+{
+	Tokens tokens;
+	bool ok = tokenize("\tlw  t0, 4(s0)\r", tokens);
+
+	return (
+		ok                                  &&
+		assertEquals(tokens.size(), 4u)     &&
+		(tokens[0] == "lw")                 &&
+		(tokens[1] == "t0")                 &&
+		(tokens[2] == "4")                  &&
+		(tokens[3] == "s0")                 &&
+		tokens[4].empty()                   &&
+		!tokenize("a b c d e f g h i", tokens)
+	);
+}
+
+bool test_assembly_concurrent(void)
+{
+	const Mips32Assembler a;
+	const std::string lines[] = { "add s0, s1, s2", "sw t0, 8(sp)", "sll t1, t2, 3", "jal 1024" };
+	isa32::word_t want[4];
+	bool ok[4] = { true, true, true, true };
+	std::vector<std::thread> threads;
+
+	for (unsigned i = 0; i < 4; i++)
+		want[i] = a.assembly(lines[i]);
+
+	// One assembler, shared by all threads.
+	for (unsigned t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&, t] {
+			for (unsigned i = 0; i < 10000; i++)
+				ok[t] = ok[t] && (a.assembly(lines[(t + i) & 3]) == want[(t + i) & 3]);
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	return (ok[0] && ok[1] && ok[2] && ok[3]);
+}
+
+bool test_encode_nor(void)
+{
+	Mips32Assembler a;
+	std::string instr = "nor s0, s1, s2";
+
+	isa32::word_t want =
+		(INST_OPCODE_NOR << INST_SHIFT_OPCODE) |
+		(REG_S1 << INST_SHIFT_RS)              |
+		(REG_S2 << INST_SHIFT_RT)              |
+		(REG_S0 << INST_SHIFT_RD)              |
+		(0 << INST_SHIFT_SHAMT)                |
+		(INST_FUNCT_NOR << INST_SHIFT_FUNCT);
+
+	isa32::word_t have = a.assembly(instr);
+
+	return (assertEquals(want, have));
+}
+
+bool test_encode_unknown(void)
+{
+	Mips32Assembler a;
+	unsigned errors = 0;
+	const std::string lines[] = { "addx s0, s1, s2", "add s0, s1, s9", "ad s0, s1, s2", "add s0, s1, zer" };
+
+	for (const std::string &line : lines)
+	{
+		try
+		{
+			a.assembly(line);
+		}
+		catch (std::invalid_argument &)
+		{
+			errors++;
+		}
+	}
+
+	return (assertEquals(errors, 4u));
+}
+
+bool test_perfect_hash(void)
+{
+	static constexpr auto table = makePerfectHash<int>({
+		{ "add", 1 }, { "addi", 2 }, { "sub", 3 }, { "", 4 },
+	});
+
+	static_assert(*table.find("addi") == 2, "perfect hash lookup");
+	static_assert(table.find("ad") == nullptr, "perfect hash miss");
+
+	return (
+		assertEquals(*table.find("add"), 1) &&
+		assertEquals(*table.find("sub"), 3) &&
+		assertEquals(*table.find(""), 4)    &&
+		(table.find("addu") == nullptr)
+	);
+}
+
+bool test_assemble_labels(void)
+{
+	Mips32Assembler a;
+	std::istringstream source(
+		"# Forward, backward and local references.\n"
+		".text\n"
+		".globl _start\n"
+		"start0: add s0, s1, s2\n"
+		"_start: beq t0, t1, done    # forward\n"
+		"1:      addi t0, t0, 1\n"
+		"        bne t0, t1, 1b\n"
+		"done:   j 1f\n"
+		"1:      jal done\n"
+		".data\n"
+		"table:  .word done, 7, -1\n"
+		"buf:    .space 6\n"
+	);
+
+	Program prog = a.assemble(source, 0x1000);
+
+	isa32::word_t beq =
+		(INST_OPCODE_BEQ << INST_SHIFT_OPCODE) |
+		(REG_T0 << INST_SHIFT_RS)              |
+		(REG_T1 << INST_SHIFT_RT)              |
+		(2 << INST_SHIFT_IMM);
+	isa32::word_t bne =
+		(INST_OPCODE_BNE << INST_SHIFT_OPCODE) |
+		(REG_T0 << INST_SHIFT_RS)              |
+		(REG_T1 << INST_SHIFT_RT)              |
+		(0xfffe << INST_SHIFT_IMM);
+	isa32::word_t j =
+		(INST_OPCODE_J << INST_SHIFT_OPCODE) |
+		((0x1014 >> 2) << INST_SHIFT_TARGET);
+	isa32::word_t jal =
+		(INST_OPCODE_JAL << INST_SHIFT_OPCODE) |
+		((0x1010 >> 2) << INST_SHIFT_TARGET);
+
+	const char *names[] = { "start0", "_start", "done", "table", "buf" };
+	isa32::word_t values[] = { 0x1000, 0x1004, 0x1010, 0x1018, 0x1024 };
+	isa32::word_t sizes[] = { 4, 12, 8, 12, 8 };
+	bool ok = assertEquals(prog.symbols.size(), 5u);
+
+	for (unsigned i = 0; ok && (i < 5); i++)
+	{
+		ok = (prog.symbols[i].name == names[i])  &&
+		     (prog.symbols[i].value == values[i]) &&
+		     (prog.symbols[i].size == sizes[i]);
+	}
+
+	return (
+		ok                                           &&
+		assertEquals(prog.words.size(), 11u)         &&
+		assertEquals(prog.textSize, 6u)              &&
+		assertEquals(prog.entry, 0x1004u)            &&
+		assertEquals(prog.words[0], a.assembly("add s0, s1, s2")) &&
+		assertEquals(prog.words[1], beq)             &&
+		assertEquals(prog.words[3], bne)             &&
+		assertEquals(prog.words[4], j)               &&
+		assertEquals(prog.words[5], jal)             &&
+		assertEquals(prog.words[6], 0x1010u)         &&
+		assertEquals(prog.words[7], 7u)              &&
+		assertEquals(prog.words[8], 0xffffffffu)     &&
+		assertEquals(prog.words[9], 0u)              &&
+		assertEquals(prog.words[10], 0u)
+	);
+}
+
+bool test_assemble_errors(void)
+{
+	Mips32Assembler a;
+	unsigned errors = 0;
+	const std::string sources[] = {
+		"j nowhere\n",
+		"x: add s0, s1, s2\nx: add s0, s1, s2\n",
+		".bss\n",
+		"beq t0, t1, 1b\n",
+		"beq t0, t1, 1f\n",
+	};
+
+	for (const std::string &source : sources)
+	{
+		std::istringstream input(source);
+
+		try
+		{
+			a.assemble(input);
+		}
+		catch (std::invalid_argument &)
+		{
+			errors++;
+		}
+	}
+
+	return (assertEquals(errors, 5u));
+}
+
+bool test_assemble_parallel(void)
+{
+	Mips32Assembler a;
+	ThreadPool pool(4);
+	const unsigned n = 20000;
+	const isa32::word_t base = 0x1000;
+	std::string source;
+
+	// Blocks of three instructions that chain to each other.
+	for (unsigned i = 0; i < n; i++)
+	{
+		if (i == n/2)
+			source += ".data\nmid: .word L" + std::to_string(n - 1) + "\n.text\n";
+		source += "L" + std::to_string(i) + ": ";
+		source += (i == 0) ? "add s0, s1, s2\n" : "bne t0, t1, 1b\n";
+		source += "beq t0, t1, 1f\n";
+		source += "j L" + std::to_string((i + 1) % n) + "\n";
+		source += "1:\n";
+	}
+
+	// Data that spans whole chunks.
+	source += ".data\n";
+	for (unsigned i = 0; i < n; i++)
+		source += ".word L" + std::to_string(i) + "\n";
+
+	std::istringstream input(source);
+	Program prog = a.assemble(input, base, pool);
+
+	if (!assertEquals(prog.words.size(), 4*n + 1) || !assertEquals(prog.textSize, 3*n))
+		return (false);
+
+	isa32::word_t bne = a.assembly("bne t0, t1, -1");
+	isa32::word_t beq = a.assembly("beq t0, t1, 1");
+	isa32::word_t add = a.assembly("add s0, s1, s2");
+	const isa32::word_t *data = &prog.words[3*n];
+	bool ok = (data[0] == base + 12*(n - 1));
+
+	for (unsigned i = 0; ok && (i < n); i++)
+	{
+		isa32::word_t next = base + 12*((i + 1) % n);
+		isa32::word_t j = (INST_OPCODE_J << INST_SHIFT_OPCODE) | ((next >> 2) << INST_SHIFT_TARGET);
+
+		ok = (prog.words[3*i] == ((i == 0) ? add : bne)) &&
+		     (prog.words[3*i + 1] == beq)                 &&
+		     (prog.words[3*i + 2] == j)                   &&
+		     (data[1 + i] == base + 12*i);
+	}
+
+	// Same program from memory, chunked without copies.
+	Program same = a.assemble(std::string_view(source), base, pool);
+
+	return (
+		ok                                         &&
+		assertEquals(prog.symbols.size(), n + 1)   &&
+		(same.words == prog.words)
+	);
+}
+
+bool test_disassemble(void)
+{
+	Mips32Assembler a;
+	Mips32Disassembler d;
+	char buf[DISASSEMBLER_MAX_LINE];
+	const char *lines[] = {
+		"add s0, s1, s2",   "nor t0, t1, t2",  "mult s0, s1",
+		"sll s0, s1, 1",    "jr ra",           "addi s0, s1, -4",
+		"andi t0, t1, 0xff", "beq t0, t1, -2", "j 1024",
+		"lui t0, 0x1234",
+	};
+	bool ok = true;
+
+	// Round trip through the assembler.
+	for (const char *line : lines)
+	{
+		d.disassemble(a.assembly(line), buf, sizeof(buf));
+		ok = ok && assertEquals(std::string(buf), std::string(line));
+	}
+
+	// Loads and stores have their data register in rt.
+	d.disassemble((INST_OPCODE_LW << INST_SHIFT_OPCODE) | (REG_SP << INST_SHIFT_RS) | (REG_RA << INST_SHIFT_RT) | 8, buf, sizeof(buf));
+	ok = ok && assertEquals(std::string(buf), std::string("lw ra, 8(sp)"));
+
+	d.disassemble(0xfc000000, buf, sizeof(buf));
+
+	return (ok && assertEquals(std::string(buf), std::string(".word 0xfc000000")));
+}
+
+bool test_pseudo_constants(void)
+{
+	Mips32Assembler a;
+	const struct { const char *line; std::vector<std::string> want; } cases[] = {
+		{ "li t0, 0",          { "addi t0, zero, 0" } },
+		{ "li t0, -1",         { "addi t0, zero, -1" } },
+		{ "li t0, 32767",      { "addi t0, zero, 32767" } },
+		{ "li t0, 0xffff",     { "ori t0, zero, 0xffff" } },
+		{ "li t0, 0x10000",    { "lui t0, 0x1" } },
+		{ "li t0, 0x12345678", { "lui t0, 0x1234", "ori t0, t0, 0x5678" } },
+		{ "li t0, -32769",     { "lui t0, 0xffff", "ori t0, t0, 0x7fff" } },
+		{ "la t0, 0x20000",    { "lui t0, 0x2" } },
+		{ "move s0, s1",       { "add s0, s1, zero" } },
+		{ "not s0, s1",        { "nor s0, s1, zero" } },
+		{ "neg s0, s1",        { "sub s0, zero, s1" } },
+		{ "nop",               { "sll zero, zero, 0" } },
+		{ "b -2",              { "beq zero, zero, -2" } },
+		{ "bnez t0, 3",        { "bne t0, zero, 3" } },
+		{ "blt t0, t1, 4",     { "slt at, t0, t1", "bne at, zero, 4" } },
+		{ "bge t0, t1, 4",     { "slt at, t0, t1", "beq at, zero, 4" } },
+		{ "bgt t0, t1, 4",     { "slt at, t1, t0", "bne at, zero, 4" } },
+		{ "ble t0, t1, 4",     { "slt at, t1, t0", "beq at, zero, 4" } },
+	};
+	bool ok = true;
+
+	// Shortest real sequence.
+	for (const auto &c : cases)
+	{
+		Program prog = a.assemble(std::string_view(c.line));
+
+		ok = ok && assertEquals(prog.words.size(), c.want.size());
+		for (size_t i = 0; ok && (i < c.want.size()); i++)
+			ok = assertEquals(prog.words[i], a.assembly(c.want[i]));
+	}
+
+	// A single word is expected.
+	try
+	{
+		a.assembly("li t0, 0x12345678");
+		ok = false;
+	}
+	catch (std::invalid_argument &)
+	{
+	}
+
+	return (ok);
+}
+
+bool test_pseudo_symbols(void)
+{
+	Mips32Assembler a;
+	Program prog = a.assemble(std::string_view(
+		"_start: la t0, value\n"
+		"loop:   blt t0, t1, loop\n"
+		"        b done\n"
+		"done:   jr ra\n"
+		".data\n"
+		"value:  .word 0\n"
+	), 0x12340000);
+
+	return (
+		assertEquals(prog.words.size(), 7u)                                  &&
+		assertEquals(prog.words[0], a.assembly("lui t0, 0x1234"))            &&
+		assertEquals(prog.words[1], a.assembly("ori t0, t0, 0x18"))          &&
+		assertEquals(prog.words[2], a.assembly("slt at, t0, t1"))            &&
+		assertEquals(prog.words[3], a.assembly("bne at, zero, -2"))          &&
+		assertEquals(prog.words[4], a.assembly("beq zero, zero, 0"))         &&
+		assertEquals(prog.symbols[1].size, 12u)
+	);
+}
+
+bool test_link_objects(void)
+{
+	Mips32Assembler a;
+	Object main = a.assembleObject(std::string_view(
+		".globl _start\n"
+		"_start: jal helper\n"
+		"        la t0, counter\n"
+		"loop:   j loop\n"
+	));
+	Object lib = a.assembleObject(std::string_view(
+		".globl helper, counter\n"
+		"helper: beq t0, t1, loop\n"
+		"loop:   jr ra\n"
+		".data\n"
+		"counter: .word helper\n"
+	));
+	std::vector<const Object *> objects = { &lib, &main };
+	Program prog = a.link(objects, 0x1000);
+
+	// Text of lib, text of main, data of lib.
+	bool ok = (
+		assertEquals(prog.words.size(), 7u)                           &&
+		assertEquals(prog.textSize, 6u)                               &&
+		assertEquals(prog.entry, 0x1008u)                             &&
+		assertEquals(prog.words[0], a.assembly("beq t0, t1, 0"))      &&
+		assertEquals(prog.words[2], a.assembly("jal 1024"))           &&
+		assertEquals(prog.words[3], a.assembly("lui t0, 0"))          &&
+		assertEquals(prog.words[4], a.assembly("ori t0, t0, 0x1018")) &&
+		assertEquals(prog.words[5], a.assembly("j 1029"))             &&
+		assertEquals(prog.words[6], 0x1000u)                          &&
+		assertEquals(prog.symbols.size(), 5u)
+	);
+
+	// Exports clash, and imports must be defined somewhere.
+	unsigned errors = 0;
+	std::vector<const Object *> twice = { &lib, &lib };
+	std::vector<const Object *> alone = { &main };
+	for (const std::vector<const Object *> *bad : { &twice, &alone })
+	{
+		try
+		{
+			a.link(*bad);
+		}
+		catch (std::invalid_argument &)
+		{
+			errors++;
+		}
+	}
+
+	return (ok && assertEquals(errors, 2u));
+}
+
+bool test_number_range(void)
+{
+	Mips32Assembler a;
+	const char *bad[] = {
+		"li t0, 0x100000000",
+		".word 4294967296",
+		".word -2147483649",
+		"addi t0, t0, 99999999999999999999",
+	};
+	unsigned errors = 0;
+
+	for (const char *source : bad)
+	{
+		try
+		{
+			a.assemble(std::string_view(source));
+		}
+		catch (std::range_error &)
+		{
+			errors++;
+		}
+	}
+
+	// Both ends of the 32-bit range still fit.
+	Program prog = a.assemble(std::string_view(".word 4294967295\n.word -2147483648\n"));
+
+	return (
+		assertEquals(errors, 4u)                 &&
+		assertEquals(prog.words[0], 0xffffffffu) &&
+		assertEquals(prog.words[1], 0x80000000u)
+	);
+}
+
 std::list<test::Test *> mips32AssemblerTests(void)
 {
 	test::Test *t;
@@ -228,6 +706,34 @@ std::list<test::Test *> mips32AssemblerTests(void)
 	tests.push_back(t);
 	t = new test::Test("j-type generic", test_encode_j_generic);
 	tests.push_back(t);
+	t = new test::Test("streaming assembly", test_assembly_stream);
+	tests.push_back(t);
+	t = new test::Test("tokenizer", test_tokenize);
+	tests.push_back(t);
+	t = new test::Test("concurrent assembly", test_assembly_concurrent);
+	tests.push_back(t);
+	t = new test::Test("nor", test_encode_nor);
+	tests.push_back(t);
+	t = new test::Test("unknown mnemonics and registers", test_encode_unknown);
+	tests.push_back(t);
+	t = new test::Test("perfect hash", test_perfect_hash);
+	tests.push_back(t);
+	t = new test::Test("labels and directives", test_assemble_labels);
+	tests.push_back(t);
+	t = new test::Test("assembly errors", test_assemble_errors);
+	tests.push_back(t);
+	t = new test::Test("parallel assembly", test_assemble_parallel);
+	tests.push_back(t);
+	t = new test::Test("disassembly", test_disassemble);
+	tests.push_back(t);
+	t = new test::Test("pseudo-instructions with constants", test_pseudo_constants);
+	tests.push_back(t);
+	t = new test::Test("pseudo-instructions with symbols", test_pseudo_symbols);
+	tests.push_back(t);
+	t = new test::Test("32-bit number range", test_number_range);
+	tests.push_back(t);
+	t = new test::Test("multi-object linking", test_link_objects);
+	tests.push_back(t);
 
 	return (tests);
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Ours
+#include <asm/rv32.h>
+#include <test.h>
+
+using namespace rv32;
+
+bool test_rv32_encode(void)
+{
+	Rv32Assembler a;
+	const struct { const char *line; isa32::word_t want; } cases[] = {
+		{ "add a0, a1, a2",    0x00c58533 },
+		{ "sub t0, t1, t2",    0x407302b3 },
+		{ "addi sp, sp, -16",  0xff010113 },
+		{ "srai a0, a0, 3",    0x40355513 },
+		{ "lw ra, 12(sp)",     0x00c12083 },
+		{ "sw ra, 12(sp)",     0x00112623 },
+		{ "jalr ra, 0(t0)",    0x000280e7 },
+		{ "beq a0, a1, 8",     0x00b50463 },
+		{ "jal 16",            0x010000ef },
+		{ "lui a0, 0x12345",   0x12345537 },
+		{ "ecall",             0x00000073 },
+		{ "ebreak",            0x00100073 },
+		{ "add x10, x11, x12", 0x00c58533 },
+	};
+	bool ok = true;
+
+	for (const auto &c : cases)
+		ok = ok && assertEquals(a.assembly(c.line), c.want);
+
+	return (ok);
+}
+
+bool test_rv32_labels(void)
+{
+	Rv32Assembler a;
+	std::istringstream source(
+		"_start: addi a0, zero, 10\n"
+		"loop:   addi a0, a0, -1\n"
+		"        bne a0, zero, loop\n"
+		"        jal ra, done\n"
+		"        ebreak\n"
+		"done:   jalr zero, 0(ra)\n"
+	);
+
+	Program prog = a.assemble(source, 0x100);
+
+	return (
+		assertEquals(prog.words.size(), 6u)         &&
+		assertEquals(prog.entry, 0x100u)            &&
+		assertEquals(prog.words[2], 0xfe051ee3u)    &&
+		assertEquals(prog.words[3], 0x008000efu)
+	);
+}
+
+bool test_rv32_errors(void)
+{
+	Rv32Assembler a;
+	unsigned errors = 0;
+	const std::string lines[] = {
+		"addi a0, a0, 2048",
+		"slli a0, a0, 32",
+		"beq a0, a1, 3",
+		"add a0, a1, x32",
+		"mult a0, a1",
+	};
+
+	for (const std::string &line : lines)
+	{
+		try
+		{
+			a.assembly(line);
+		}
+		catch (std::exception &)
+		{
+			errors++;
+		}
+	}
+
+	return (assertEquals(errors, 5u));
+}
+
+bool test_rv32_disassemble(void)
+{
+	Rv32Assembler a;
+	Rv32Disassembler d;
+	char buf[DISASSEMBLER_MAX_LINE];
+	const char *lines[] = {
+		"add a0, a1, a2",   "sub t0, t1, t2",   "sra s2, s3, t6",
+		"addi sp, sp, -16", "srai a0, a0, 3",   "slli a0, a0, 31",
+		"lw ra, 12(sp)",    "lbu t0, -1(a0)",   "sw ra, 12(sp)",
+		"sb t0, -1(a0)",    "jalr ra, 0(t0)",   "beq a0, a1, 8",
+		"bne a0, zero, -4", "jal ra, 16",       "jal zero, -2048",
+		"lui a0, 0x12345",  "auipc t1, 0xfffff", "fence",
+		"ecall",            "ebreak",
+	};
+	bool ok = true;
+
+	// Round trip through the assembler.
+	for (const char *line : lines)
+	{
+		d.disassemble(a.assembly(line), buf, sizeof(buf));
+		ok = ok && assertEquals(std::string(buf), std::string(line));
+	}
+
+	d.disassemble(0xffffffff, buf, sizeof(buf));
+
+	return (ok && assertEquals(std::string(buf), std::string(".word 0xffffffff")));
+}
+
+bool test_rv32_disassemble_range(void)
+{
+	Rv32Disassembler d;
+	const isa32::word_t words[] = { 0x00c58533, 0x00000073 };
+	char buf[128];
+	char small[4];
+
+	size_t length = d.disassemble(words, 2, 0x100, buf, sizeof(buf));
+	std::string want = "0x00000100:\tadd a0, a1, a2\n0x00000104:\tecall\n";
+
+	return (
+		assertEquals(length, want.size())                     &&
+		assertEquals(std::string(buf), want)                  &&
+		assertEquals(d.disassemble(words[0], small, sizeof(small)), 14u) &&
+		assertEquals(std::string(small), std::string("add"))
+	);
+}
+
+bool test_rv32_constexpr(void)
+{
+	static constexpr const char source[] =
+		"_start: addi a0, zero, 10  # counter\n"
+		"1:      addi a0, a0, -1\n"
+		"        bne a0, zero, 1b\n"
+		"        jal ra, done\n"
+		"        ebreak\n"
+		"done:   jalr zero, 0(ra)\n"
+		"table:  .word done, 0x2a\n";
+	static constexpr auto program = RV32_ASSEMBLE(source);
+
+	// Encoded by the compiler.
+	static_assert(program.size() == 8, "wrong size");
+	static_assert(program[0] == 0x00a00513, "wrong encoding");
+	static_assert(program[2] == 0xfe051ee3, "wrong backward branch");
+	static_assert(program[3] == 0x008000ef, "wrong forward jump");
+
+	Rv32Assembler a;
+	std::istringstream input(source);
+	Program prog = a.assemble(input, 0x100);
+	auto relocated = assemble<size(source)>(source, 0x100);
+	bool ok = assertEquals(prog.words.size(), relocated.size());
+
+	// Same words as the run-time assembler.
+	for (size_t i = 0; ok && (i < relocated.size()); i++)
+		ok = assertEquals(prog.words[i], relocated[i]);
+
+	return (ok && assertEquals(program[6], 20u) && assertEquals(relocated[6], 0x114u));
+}
+
+std::list<test::Test *> rv32AssemblerTests(void)
+{
+	test::Test *t;
+	std::list<test::Test *> tests;
+
+	t = new test::Test("rv32 encoding", test_rv32_encode);
+	tests.push_back(t);
+	t = new test::Test("rv32 labels", test_rv32_labels);
+	tests.push_back(t);
+	t = new test::Test("rv32 errors", test_rv32_errors);
+	tests.push_back(t);
+	t = new test::Test("rv32 disassembly", test_rv32_disassemble);
+	tests.push_back(t);
+	t = new test::Test("rv32 disassembly of a range", test_rv32_disassemble_range);
+	tests.push_back(t);
+	t = new test::Test("rv32 compile-time assembly", test_rv32_constexpr);
+	tests.push_back(t);
+
+	return (tests);
+}
@@ -31,8 +31,10 @@
 
 // Import definitions.
 extern std::list<test::Test *> mips32AssemblerTests(void);
+extern std::list<test::Test *> rv32AssemblerTests(void);
 extern std::list<test::Test *> vmachineTests(void);
 extern std::list<test::Test *> engineTests(void);
+extern std::list<test::Test *> cacheTests(void);
 
 // Top-Level test driver.
 void testDriver(void)
@@ -40,8 +42,10 @@ void testDriver(void)
 	std::list<test::Test *> tests;
 
 	tests.merge(mips32AssemblerTests());
+	tests.merge(rv32AssemblerTests());
 	tests.merge(vmachineTests());
 	tests.merge(engineTests());
+	tests.merge(cacheTests());
 
 	// Run Regression tests.
 	for (auto it = tests.begin(); it != tests.end(); ++it)
@@ -0,0 +1,303 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <list>
+
+// Ours
+#include <config.h>
+#include <test.h>
+#include <vmachine/cache.h>
+
+bool test_cache_hit(void)
+{
+	Cache cache(VMACHINE_DEFAULT_CACHE_SIZE);
+
+	bool first = cache.access(0x40);
+	bool second = cache.access(0x44);
+
+	return (
+		assertEquals(first, false)        &&
+		assertEquals(second, true)        &&
+		assertEquals(cache.getHits(), 1u) &&
+		assertEquals(cache.getMisses(), 1u)
+	);
+}
+
+bool test_cache_lru(void)
+{
+	const unsigned ways = 4;
+	const unsigned lineSize = 16;
+	Cache cache(ways*lineSize, ways, lineSize);
+
+	// Fill the single set, then touch line 0 again.
+	for (unsigned i = 0; i < ways; i++)
+		cache.access(i*lineSize);
+	cache.access(0);
+
+	// Line 1 is now the least recently used.
+	cache.access(ways*lineSize);
+
+	return (
+		assertEquals(cache.probe(0), true)         &&
+		assertEquals(cache.probe(lineSize), false) &&
+		assertEquals(cache.probe(2*lineSize), true)
+	);
+}
+
+bool test_cache_invalidate(void)
+{
+	Cache cache(VMACHINE_DEFAULT_CACHE_SIZE);
+
+	cache.access(0x80);
+	cache.invalidate(0x80);
+
+	return (assertEquals(cache.probe(0x80), false));
+}
+
+bool test_cache_lookup_impl(void)
+{
+	static const Cache::LookupImpl impls[] = {
+		Cache::LOOKUP_SCALAR, Cache::LOOKUP_SSE2, Cache::LOOKUP_AVX2
+	};
+	Cache::LookupImpl saved = Cache::getLookupImpl();
+	bool ok = true;
+
+	// All implementations must agree, for every associativity.
+	for (unsigned ways = 1; ways <= Cache::MAX_WAYS; ways++)
+	{
+		for (auto impl : impls)
+		{
+			if (!Cache::setLookupImpl(impl))
+				continue;
+
+			Cache cache(ways*64, ways, 16);
+
+			for (unsigned i = 0; i < ways; i++)
+				cache.access(i*64);
+
+			for (unsigned i = 0; i < ways; i++)
+				ok &= cache.probe(i*64);
+			ok &= !cache.probe(ways*64);
+		}
+	}
+
+	Cache::setLookupImpl(saved);
+
+	return (ok);
+}
+
+bool test_prefetch_next_line(void)
+{
+	const unsigned lines = 64;
+	Cache cache(1024, 4, 16);
+	NextLinePrefetcher prefetcher;
+
+	cache.attach(prefetcher);
+
+	for (unsigned i = 0; i < lines; i++)
+		cache.access(i*16);
+
+	const PrefetchStats &stats = cache.getPrefetchStats();
+
+	return (
+		(stats.useful > 0)                              &&
+		(cache.getMisses() + stats.useful == lines)     &&
+		(cache.getPrefetchCoverage() > 0.5)
+	);
+}
+
+bool test_prefetch_next_level(void)
+{
+	const unsigned lines = 64;
+	Cache l1(1024, 4, 16);
+	Cache l2(4096, 4, 16);
+	NextLinePrefetcher prefetcher;
+	StridePrefetcher l2prefetcher;
+
+	l1.attach(l2);
+	l1.attach(prefetcher);
+	l2.attach(l2prefetcher);
+
+	for (unsigned i = 0; i < lines; i++)
+		l1.access(i*16, 0x100);
+
+	// Only demand misses of L1 reach L2 as accesses.
+	return (
+		(l1.getPrefetchStats().issued > 0)                          &&
+		assertEquals(l2.getHits() + l2.getMisses(), l1.getMisses()) &&
+		assertEquals(l2.getPrefetchStats().issued, 0u)
+	);
+}
+
+bool test_prefetch_stride(void)
+{
+	const isa32::word_t pc = 0x100;
+	const unsigned stride = 3*16;
+	Cache cache(1024, 4, 16);
+	StridePrefetcher prefetcher;
+
+	cache.attach(prefetcher);
+
+	for (unsigned i = 0; i < 16; i++)
+		cache.access(i*stride, pc);
+
+	const PrefetchStats &stats = cache.getPrefetchStats();
+
+	return (
+		(stats.useful > 0) &&
+		(cache.getPrefetchAccuracy() > 0.5)
+	);
+}
+
+bool test_prefetch_stream(void)
+{
+	Cache cache(1024, 4, 16);
+	StreamPrefetcher prefetcher;
+
+	cache.attach(prefetcher);
+
+	// Descending stream.
+	for (unsigned i = 32; i > 0; i--)
+		cache.access(0x800 + i*16);
+
+	return (cache.getPrefetchStats().useful > 0);
+}
+
+bool test_coherence_mesi(void)
+{
+	Directory directory;
+	DCache a(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache b(VMACHINE_DEFAULT_CACHE_SIZE);
+
+	a.attach(directory);
+	b.attach(directory);
+
+	a.access(0x40);
+	bool exclusive = (a.getState(0x40) == MESI_EXCLUSIVE);
+
+	b.access(0x40);
+	bool shared = (a.getState(0x40) == MESI_SHARED) && (b.getState(0x40) == MESI_SHARED);
+
+	a.access(0x40, 0, true);
+	bool modified = (a.getState(0x40) == MESI_MODIFIED) && (b.getState(0x40) == MESI_INVALID);
+
+	b.access(0x40);
+	bool downgraded = (a.getState(0x40) == MESI_SHARED) && (b.getState(0x40) == MESI_SHARED);
+
+	const CoherenceStats &stats = directory.getStats();
+
+	return (
+		exclusive                                 &&
+		shared                                    &&
+		modified                                  &&
+		downgraded                                &&
+		assertEquals(stats.upgrades, 1u)          &&
+		assertEquals(stats.invalidations, 1u)     &&
+		assertEquals(stats.coherenceMisses, 1u)   &&
+		assertEquals(stats.writebacks, 1u)
+	);
+}
+
+bool test_coherence_eviction(void)
+{
+	Directory directory;
+	DCache a(VMACHINE_DEFAULT_CACHE_SIZE);
+
+	a.attach(directory);
+
+	// Touch far more lines than the cache holds.
+	for (unsigned i = 0; i < 64; i++)
+		a.access(i*VMACHINE_DEFAULT_CACHE_LINE_SIZE, 0, true);
+
+	unsigned lines = VMACHINE_DEFAULT_CACHE_SIZE/VMACHINE_DEFAULT_CACHE_LINE_SIZE;
+
+	return (
+		assertEquals(directory.getLines(), lines) &&
+		assertEquals(directory.getStats().writebacks, 64u - lines)
+	);
+}
+
+bool test_icache_fetch_buffer(void)
+{
+	const unsigned lineSize = 16;
+	const unsigned words = lineSize/sizeof(isa32::word_t);
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE, VMACHINE_DEFAULT_CACHE_WAYS, lineSize);
+	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+	bool ok = true;
+
+	for (unsigned i = 0; i < 2*words; i++)
+		memory.write(i*sizeof(isa32::word_t), i);
+	icache.attach(memory);
+
+	// Only the first fetch of each line looks up the tags.
+	for (unsigned i = 0; i < 2*words; i++)
+		ok = ok && (icache.fetch(i*sizeof(isa32::word_t)) == i);
+
+	// Dropping the buffered line forces a new lookup.
+	icache.invalidate(lineSize);
+	ok = ok && (icache.fetch(lineSize) == words);
+
+	// Stores to the buffered line are seen by the next fetch.
+	memory.write(lineSize + sizeof(isa32::word_t), 0xcafe);
+	ok = ok && (icache.fetch(lineSize + sizeof(isa32::word_t)) == 0xcafe);
+
+	return (
+		ok                                                 &&
+		assertEquals(icache.getMisses(), 3u)               &&
+		assertEquals(icache.getHits(), 0u)                 &&
+		assertEquals(icache.getBufferHits(), 2u*(words - 1) + 1)
+	);
+}
+
+std::list<test::Test *> cacheTests(void)
+{
+	test::Test *t;
+	std::list<test::Test *> tests;
+
+	t = new test::Test("cache hit", test_cache_hit);
+	tests.push_back(t);
+	t = new test::Test("cache lru replacement", test_cache_lru);
+	tests.push_back(t);
+	t = new test::Test("cache invalidate", test_cache_invalidate);
+	tests.push_back(t);
+	t = new test::Test("cache lookup implementations", test_cache_lookup_impl);
+	tests.push_back(t);
+	t = new test::Test("icache fetch buffer", test_icache_fetch_buffer);
+	tests.push_back(t);
+	t = new test::Test("next-line prefetcher", test_prefetch_next_line);
+	tests.push_back(t);
+	t = new test::Test("prefetch fills in the next level", test_prefetch_next_level);
+	tests.push_back(t);
+	t = new test::Test("stride prefetcher", test_prefetch_stride);
+	tests.push_back(t);
+	t = new test::Test("stream prefetcher", test_prefetch_stream);
+	tests.push_back(t);
+	t = new test::Test("mesi coherence", test_coherence_mesi);
+	tests.push_back(t);
+	t = new test::Test("coherence directory eviction", test_coherence_eviction);
+	tests.push_back(t);
+
+	return (tests);
+}
@@ -23,6 +23,8 @@
 //
 
 #include <list>
+#include <thread>
+#include <vector>
 
 #include <vmachine.h>
 #include <test.h>
@@ -147,6 +149,70 @@ bool test_engine_multu(void){
 	return assertEquals(engine.engine_run(34668569),51906227);
 }
 
+bool test_engine_stateless(void){
+	const Engine engine;
+	isa32::word_t want = engine.engine_run(34668570);
+
+	// add $t5,$s1,$s2 must not change how later instructions are translated.
+	engine.engine_run(36857888);
+
+	// div $s0,$s1
+	return assertEquals(engine.engine_run(34668570),want);
+}
+
+bool test_engine_concurrent(void){
+	const Engine engine;
+	const isa32::word_t mips[4] = { 36864032, 65011720, 1147520, 34668570 };
+	isa32::word_t want[4];
+	bool ok[4] = { true, true, true, true };
+	std::vector<std::thread> threads;
+
+	for (unsigned i = 0; i < 4; i++)
+		want[i] = engine.engine_run(mips[i]);
+
+	// One engine, shared by all threads.
+	for (unsigned t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&, t] {
+			for (unsigned i = 0; i < 10000; i++)
+				ok[t] = ok[t] && (engine.engine_run(mips[(t + i) & 3]) == want[(t + i) & 3]);
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	return (ok[0] && ok[1] && ok[2] && ok[3]);
+}
+
+bool test_engine_buffer(void){
+	const Engine engine;
+
+	// div $s0,$s1
+	Translation t = engine.translate(34668570);
+	TranslationBuffer buffer = engine.getBuffer(t);
+
+	return (assertEquals(buffer.count, 3u) &&
+		assertEquals(buffer.words[0], 51922611u) &&
+		assertEquals(buffer.words[1], t.rv_instructionAddi) &&
+		assertEquals(buffer.words[2], 19u));
+}
+
+bool test_engine_buffer_full(void){
+	TranslationBuffer buffer;
+	bool thrown = false;
+
+	for (unsigned i = 0; i < ENGINE_MAX_WORDS; i++)
+		buffer.push(i);
+
+	try {
+		buffer.push(ENGINE_MAX_WORDS);
+	} catch (const std::length_error &) {
+		thrown = true;
+	}
+
+	return (thrown && assertEquals(buffer.count, (size_t)ENGINE_MAX_WORDS));
+}
+
 std::list<test::Test *> engineTests(void)
 {
 	test::Test *t;
@@ -184,6 +250,14 @@ std::list<test::Test *> engineTests(void)
 	tests.push_back(t);
 	t = new test::Test("Tranlate MIPS multu to RISC-V",test_engine_multu);
 	tests.push_back(t);
+	t = new test::Test("Translate independently of earlier instructions",test_engine_stateless);
+	tests.push_back(t);
+	t = new test::Test("Translate concurrently with a shared engine",test_engine_concurrent);
+	tests.push_back(t);
+	t = new test::Test("Translate into an inline buffer",test_engine_buffer);
+	tests.push_back(t);
+	t = new test::Test("Reject words past the end of the buffer",test_engine_buffer_full);
+	tests.push_back(t);
 	
 
     return (tests);
@@ -23,14 +23,29 @@
 //
 
 // Theirs
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
 #include <list>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Ours
+#include <asm/rv32.h>
 #include <config.h>
 #include <test.h>
 #include <arch.h>
 #include <vmachine.h>
+#include <vmachine/image.h>
 
 using namespace vmachine;
 
@@ -88,7 +103,7 @@ bool test_execute_J(void)
 	isa32::word_t inst =
 		(INST_OPCODE_JAL)                       |
 		(REG_8        << INST_SHIFT_RD)         |
-		(0x1e         << INST_SHIFT_IMMEDIATE);
+		(0x1e         << INST_SHIFT_IMMEDIATE_I_TYPE);
 
 	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
 	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
@@ -108,12 +123,17 @@ bool test_execute_J(void)
 
 bool test_execute_S(void)
 {
+	isa32::word_t li =
+		(I_TYPE_REGISTERS_INSTRUCTIONS)           |
+		(INST_ADDI_FUNCT_3 << INST_SHIFT_FUNCT_3) |
+		(REG_17            << INST_SHIFT_RD)      |
+		(0x2a              << INST_SHIFT_IMMEDIATE_I_TYPE);
 	isa32::word_t inst =
 		(S_TYPE_INSTRUCTIONS)                   |
 		(INST_SW_FUNCT_3 << INST_SHIFT_FUNCT_3) |
 		(REG_16          << INST_SHIFT_RS_1)    |
 		(REG_17          << INST_SHIFT_RS_2)    |
-		(0x1e            << INST_SHIFT_FUNCT_7);
+		(0x1c            << INST_SHIFT_RD);
 
 	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
 	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
@@ -125,9 +145,11 @@ bool test_execute_S(void)
 		memory
 	);
 
+	vm.execute(li);
 	vm.execute(inst);
+	dcache.flush();
 
-	return (assertEquals(memory.read(0x1e), 0x00));
+	return (assertEquals(memory.read(0x1c), 0x2au));
 }
 
 bool test_execute_B(void)
@@ -137,7 +159,7 @@ bool test_execute_B(void)
 		(INST_BEQ_FUNCT_3        << INST_SHIFT_FUNCT_3) |
 		(REG_16                << INST_SHIFT_RS_1)      |
 		(REG_17                << INST_SHIFT_RS_2)      |
-		(0x1e                << INST_SHIFT_FUNCT_7);
+		(0x1e                << INST_SHIFT_RD);
 
 	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
 	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
@@ -177,6 +199,589 @@ bool test_execute_U(void)
 	return (assertEquals(vm.getRegister(REG_16), 0x1e << 12));
 }
 
+bool test_timing(void)
+{
+	isa32::word_t inst =
+		(I_TYPE_LOAD_INSTRUCTIONS)                |
+		(INST_LW_FUNCT_3   << INST_SHIFT_FUNCT_3) |
+		(REG_16            << INST_SHIFT_RS_1)    |
+		(REG_17            << INST_SHIFT_RD);
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	const uint64_t hit = VMACHINE_DEFAULT_CORE_LATENCY + VMACHINE_DEFAULT_CACHE_LATENCY;
+	const uint64_t miss = hit + VMACHINE_DEFAULT_MEMORY_LATENCY;
+
+	// Cold miss, then a hit on the same line.
+	vm.execute(inst);
+	bool cold = assertEquals(vm.getCycles(), miss);
+	vm.execute(inst);
+	bool warm = assertEquals(vm.getCycles(), miss + hit);
+
+	std::stringstream report;
+	vm.shutdown(report);
+
+	return (
+		cold                                     &&
+		warm                                     &&
+		assertEquals(vm.getInstructions(), 2u)   &&
+		(report.str().find("cpi ") != std::string::npos)
+	);
+}
+
+// Creates a scratch directory of a test.
+static std::string makeTempDir(void)
+{
+	char path[] = "/tmp/vmachine-test-XXXXXX";
+
+	if (mkdtemp(path) == nullptr)
+		throw std::runtime_error("cannot create scratch directory");
+
+	return (path);
+}
+
+// Removes a scratch directory and everything in it.
+static void removeTempDir(const std::string &dir)
+{
+	DIR *d = opendir(dir.c_str());
+
+	for (struct dirent *e; (d != nullptr) && ((e = readdir(d)) != nullptr); )
+	{
+		std::string path = dir + "/" + e->d_name;
+		struct stat st;
+
+		if (e->d_name[0] == '.')
+			continue;
+
+		if ((lstat(path.c_str(), &st) == 0) && S_ISDIR(st.st_mode))
+			removeTempDir(path);
+		else
+			std::remove(path.c_str());
+	}
+	if (d != nullptr)
+		closedir(d);
+
+	rmdir(dir.c_str());
+}
+
+// Writes a small ELF32 executable.
+static void writeElf(const std::string &path)
+{
+	std::vector<char> image(0x2008, 0);
+	Elf32_Ehdr *ehdr = reinterpret_cast<Elf32_Ehdr *>(&image[0]);
+	Elf32_Phdr *phdr = reinterpret_cast<Elf32_Phdr *>(&image[sizeof(Elf32_Ehdr)]);
+	isa32::word_t *words = reinterpret_cast<isa32::word_t *>(&image[0]);
+
+	memcpy(ehdr->e_ident, ELFMAG, SELFMAG);
+	ehdr->e_ident[EI_CLASS] = ELFCLASS32;
+	ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr->e_type = ET_EXEC;
+	ehdr->e_machine = EM_RISCV;
+	ehdr->e_entry = 0x1004;
+	ehdr->e_phoff = sizeof(Elf32_Ehdr);
+	ehdr->e_phentsize = sizeof(Elf32_Phdr);
+	ehdr->e_phnum = 2;
+
+	// Page-congruent text and .bss.
+	phdr[0].p_type = PT_LOAD;
+	phdr[0].p_offset = 0x1000;
+	phdr[0].p_vaddr = 0x1000;
+	phdr[0].p_filesz = 0x1008;
+	phdr[0].p_memsz = 0x3000;
+
+	// Unaligned data.
+	phdr[1].p_type = PT_LOAD;
+	phdr[1].p_offset = 0x100;
+	phdr[1].p_vaddr = 0x5004;
+	phdr[1].p_filesz = 8;
+	phdr[1].p_memsz = 8;
+
+	words[0x100/4] = 0xcafe;
+	words[0x1004/4] = 0x1234;
+	words[0x2004/4] = 0x5678;
+
+	// Symbol table.
+	const char strtab[] = "\0main\0data";
+	Elf32_Sym *sym = reinterpret_cast<Elf32_Sym *>(&image[0x320]);
+	Elf32_Shdr *shdr = reinterpret_cast<Elf32_Shdr *>(&image[0x380]);
+
+	memcpy(&image[0x300], strtab, sizeof(strtab));
+	sym[1] = {1, 0x1004, 8, ELF32_ST_INFO(STB_GLOBAL, STT_FUNC), 0, 1};
+	sym[2] = {6, 0x5004, 8, ELF32_ST_INFO(STB_GLOBAL, STT_OBJECT), 0, 1};
+	shdr[1].sh_type = SHT_SYMTAB;
+	shdr[1].sh_offset = 0x320;
+	shdr[1].sh_size = 3*sizeof(Elf32_Sym);
+	shdr[1].sh_link = 2;
+	shdr[2].sh_type = SHT_STRTAB;
+	shdr[2].sh_offset = 0x300;
+	shdr[2].sh_size = sizeof(strtab);
+	ehdr->e_shoff = 0x380;
+	ehdr->e_shentsize = sizeof(Elf32_Shdr);
+	ehdr->e_shnum = 3;
+
+	std::ofstream(path, std::ios::binary).write(&image[0], image.size());
+}
+
+// Checks that the executable of writeElf() was loaded.
+static bool checkLoaded(VMachine &vm, Memory &memory)
+{
+	return (
+		assertEquals(vm.getPC(), 0x1004u)           &&
+		assertEquals(memory.read(0x1004), 0x1234u)  &&
+		assertEquals(memory.read(0x2004), 0x5678u)  &&
+		assertEquals(memory.read(0x2100), 0u)       &&
+		assertEquals(memory.read(0x3800), 0u)       &&
+		assertEquals(memory.read(0x5004), 0xcafeu)  &&
+		assertEquals(vm.getSymbols().size(), 2u)    &&
+		(vm.getSymbols().describe(0x1008) == "main+0x4") &&
+		(vm.getSymbols().describe(0x5004) == "data+0x0") &&
+		(vm.getSymbols().lookup(0x100c) == nullptr)
+	);
+}
+
+bool test_load_elf(void)
+{
+	std::string tmp = makeTempDir();
+	std::string path = tmp + "/vmachine-test.elf";
+
+	writeElf(path);
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	// Stale contents must not leak into .bss.
+	memory.write(0x2100, 0xbeef);
+	memory.write(0x3800, 0xdead);
+
+	vm.loadFile(path);
+	removeTempDir(tmp);
+
+	// Unaligned contents are read in on first touch.
+	uint64_t faults = memory.getFaults();
+
+	return (
+		checkLoaded(vm, memory)          &&
+		assertEquals(faults, 0u)         &&
+		assertEquals(memory.getFaults(), 2u)
+	);
+}
+
+bool test_load_eager(void)
+{
+	std::string tmp = makeTempDir();
+	std::string path = tmp + "/vmachine-test.elf";
+
+	writeElf(path);
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	vm.loadFile(path, true);
+	removeTempDir(tmp);
+
+	// Everything was read in upfront.
+	return (
+		checkLoaded(vm, memory)            &&
+		assertEquals(memory.getFaults(), 0u)
+	);
+}
+
+bool test_load_truncated(void)
+{
+	std::string tmp = makeTempDir();
+	std::string elf = tmp + "/vmachine-test.elf";
+	std::string img = tmp + "/vmachine-test.vmimg";
+	bool elfRejected = false;
+	bool imgRejected = false;
+	struct stat st;
+
+	writeElf(elf);
+	Image::fromElf(elf).write(img);
+
+	// Cut the last words of the text segment.
+	bool ok = (truncate(elf.c_str(), 0x2000) == 0) && (stat(img.c_str(), &st) == 0) &&
+		(truncate(img.c_str(), st.st_size - 4) == 0);
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	try
+	{
+		vm.loadFile(elf);
+	}
+	catch (const std::invalid_argument &)
+	{
+		elfRejected = true;
+	}
+
+	try
+	{
+		vm.loadImage(img);
+	}
+	catch (const std::invalid_argument &)
+	{
+		imgRejected = true;
+	}
+
+	removeTempDir(tmp);
+
+	return (ok && elfRejected && imgRejected);
+}
+
+// Counts open file descriptors.
+static unsigned countFds(void)
+{
+	unsigned count = 0;
+	DIR *d = opendir("/proc/self/fd");
+
+	for (struct dirent *e; (d != nullptr) && ((e = readdir(d)) != nullptr); )
+	{
+		if (e->d_name[0] != '.')
+			count++;
+	}
+	if (d != nullptr)
+		closedir(d);
+
+	return (count);
+}
+
+bool test_memory_backings(void)
+{
+	std::string tmp = makeTempDir();
+	std::string path = tmp + "/vmachine-test.bin";
+	std::vector<isa32::word_t> words(64);
+	Memory memory(0x8000);
+	uint64_t faults;
+	unsigned fds;
+	int fd;
+
+	for (unsigned i = 0; i < words.size(); i++)
+		words[i] = i;
+	std::ofstream(path, std::ios::binary).write(reinterpret_cast<char *>(words.data()), words.size()*sizeof(isa32::word_t));
+
+	fd = open(path.c_str(), O_RDONLY);
+	removeTempDir(tmp);
+	if (fd < 0)
+		return (false);
+
+	unsigned before = countFds();
+
+	// Overwritten pages drop their pending contents unread.
+	for (unsigned i = 0; i < 4096; i++)
+	{
+		memory.map(0x1000, fd, 4, 0x80);
+		memory.zero(0x1000, 0x1000);
+	}
+	faults = memory.getFaults();
+
+	memory.map(0x1000, fd, 4, 0x80);
+	fds = countFds();
+	bool ok = assertEquals(memory.read(0x1000), 1u);
+	close(fd);
+
+	return (
+		ok                                &&
+		assertEquals(faults, 0u)          &&
+		assertEquals(fds, before + 1)     &&
+		assertEquals(countFds(), before - 1)
+	);
+}
+
+bool test_load_image(void)
+{
+	std::string tmp = makeTempDir();
+	std::string elf = tmp + "/vmachine-test.elf";
+	std::string img = tmp + "/vmachine-test.vmimg";
+
+	writeElf(elf);
+	Image::fromElf(elf).write(img);
+	std::remove(elf.c_str());
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	memory.write(0x2100, 0xbeef);
+	memory.write(0x3800, 0xdead);
+
+	vm.loadImage(img);
+	removeTempDir(tmp);
+
+	return (checkLoaded(vm, memory));
+}
+
+bool test_load_shared(void)
+{
+	std::string tmp = makeTempDir();
+	std::string elf = tmp + "/vmachine-test.elf";
+
+	writeElf(elf);
+	std::shared_ptr<SharedImage> img1 = SharedImage::open(elf);
+	std::shared_ptr<SharedImage> img2 = SharedImage::open(elf);
+	removeTempDir(tmp);
+
+	ICache icache1(VMACHINE_DEFAULT_CACHE_SIZE), icache2(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache1(VMACHINE_DEFAULT_CACHE_SIZE), dcache2(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory1(0x8000), memory2(0x8000);
+
+	VMachine vm1(icache1, dcache1, memory1);
+	VMachine vm2(icache2, dcache2, memory2);
+
+	vm1.load(img1);
+	vm2.load(img2);
+
+	// Writes stay private to the writer.
+	memory1.write(0x1004, 0x4321);
+
+	return (
+		(img1 == img2)                               &&
+		checkLoaded(vm2, memory2)                    &&
+		assertEquals(memory1.read(0x1004), 0x4321u)
+	);
+}
+
+bool test_load_cached(void)
+{
+	// A fresh cache: no leftover entry can satisfy the loads.
+	std::string tmp = makeTempDir();
+	std::string dir = tmp + "/cache";
+	std::string src = tmp + "/vmachine-test.s";
+	std::string cached;
+	bool ok;
+
+	setenv("VMACHINE_ASM_CACHE", dir.c_str(), 1);
+	std::ofstream(src) << "add s0, s1, s2" << std::endl;
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	vm.load(src);
+	isa32::word_t inst = memory.read(0);
+
+	// Find the cached image.
+	DIR *d = opendir(dir.c_str());
+	for (struct dirent *e; (d != nullptr) && ((e = readdir(d)) != nullptr); )
+	{
+		if (e->d_name[0] != '.')
+			cached = dir + "/" + e->d_name;
+	}
+	if (d != nullptr)
+		closedir(d);
+	ok = !cached.empty();
+
+	// A second load must come from the cache.
+	if (ok)
+	{
+		Image img;
+		isa32::word_t marker = ~inst;
+
+		img.segments.push_back({0, sizeof(marker), std::vector<char>(sizeof(marker))});
+		memcpy(img.segments[0].data.data(), &marker, sizeof(marker));
+		img.write(cached);
+
+		vm.load(src);
+		ok = assertEquals(memory.read(0), marker);
+
+		// An entry that cannot be mapped is assembled again.
+		img.segments[0].vaddr = VMACHINE_DEFAULT_MEMORY_SIZE;
+		img.write(cached);
+
+		vm.load(src);
+		ok = ok && assertEquals(memory.read(0), inst);
+	}
+
+	removeTempDir(tmp);
+	unsetenv("VMACHINE_ASM_CACHE");
+
+	return (ok && (inst != 0));
+}
+
+bool test_load_rv32(void)
+{
+	std::string tmp = makeTempDir();
+	std::string src = tmp + "/vmachine-test-rv32.s";
+
+	// Nowhere to cache the program.
+	setenv("VMACHINE_ASM_CACHE", "/nonexistent/vmachine-cache", 1);
+	std::ofstream(src) <<
+		"_start: addi a0, zero, 10\n"
+		"loop:   addi a0, a0, -1\n"
+		"        bne a0, zero, loop\n";
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	vm.load(src, rv32::Rv32Assembler());
+
+	removeTempDir(tmp);
+	unsetenv("VMACHINE_ASM_CACHE");
+
+	return (
+		assertEquals(memory.read(0), 0x00a00513u)         &&
+		assertEquals(memory.read(8), 0xfe051ee3u)         &&
+		(vm.getSymbols().describe(0x8) == "loop+0x4")
+	);
+}
+
+bool test_run_rv32(void)
+{
+	std::string tmp = makeTempDir();
+	std::string src = tmp + "/vmachine-test-run-rv32.s";
+
+	// Nowhere to cache the program.
+	setenv("VMACHINE_ASM_CACHE", "/nonexistent/vmachine-cache", 1);
+	std::ofstream(src) <<
+		"_start: addi a0, zero, 10\n"
+		"        jal count\n"
+		"        jal zero, end\n"
+		"count:  addi a0, a0, -1\n"
+		"        bne a0, zero, count\n"
+		"        jalr zero, 0(ra)\n"
+		"end:    addi zero, zero, 0\n";
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	vm.load(src, rv32::Rv32Assembler());
+
+	removeTempDir(tmp);
+	unsetenv("VMACHINE_ASM_CACHE");
+
+	// Bound the run in case a branch goes astray.
+	for (unsigned i = 0; (i < 100) && (vm.getPC() != 0x18); i++)
+		vm.step();
+
+	return (
+		assertEquals(vm.getPC(), 0x18u)      &&
+		assertEquals(vm.getRegister(10), 0u) &&
+		assertEquals(vm.getRegister(1), 0x8u)
+	);
+}
+
+bool test_write_elf(void)
+{
+	std::string tmp = makeTempDir();
+	std::string elf = tmp + "/vmachine-test.elf";
+	std::string out = tmp + "/vmachine-test-out.elf";
+
+	writeElf(elf);
+	Image::fromElf(elf).writeElf(out);
+	std::remove(elf.c_str());
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	memory.write(0x2100, 0xbeef);
+	memory.write(0x3800, 0xdead);
+
+	vm.loadFile(out);
+	removeTempDir(tmp);
+
+	return (checkLoaded(vm, memory));
+}
+
+bool test_write_elf_from_source(void)
+{
+	std::string tmp = makeTempDir();
+	std::string out = tmp + "/vmachine-test-rv32.elf";
+	rv32::Rv32Assembler assembler;
+
+	Program prog = assembler.assemble(
+		"_start: addi a0, zero, 10\n"
+		"loop:   addi a0, a0, -1\n"
+		"        bne a0, zero, loop\n"
+		".data\n"
+		"value:  .word loop\n",
+		0x1000
+	);
+	Image::fromProgram(prog).writeElf(out);
+
+	ICache icache(VMACHINE_DEFAULT_CACHE_SIZE);
+	DCache dcache(VMACHINE_DEFAULT_CACHE_SIZE);
+	Memory memory(0x8000);
+
+	VMachine vm(
+		icache,
+		dcache,
+		memory
+	);
+
+	vm.loadFile(out);
+	removeTempDir(tmp);
+
+	return (
+		assertEquals(vm.getPC(), 0x1000u)                 &&
+		assertEquals(memory.read(0x1000), 0x00a00513u)    &&
+		assertEquals(memory.read(0x1008), 0xfe051ee3u)    &&
+		assertEquals(memory.read(0x100c), 0x1004u)        &&
+		(vm.getSymbols().describe(0x1008) == "loop+0x4")  &&
+		(vm.getSymbols().describe(0x100c) == "value+0x0")
+	);
+}
+
 std::list<test::Test *> vmachineTests(void)
 {
 	test::Test *t;
@@ -194,6 +799,30 @@ std::list<test::Test *> vmachineTests(void)
 	tests.push_back(t);
 	t = new test::Test("execute U-type instruction", test_execute_U);
 	tests.push_back(t);
+	t = new test::Test("cycle accounting", test_timing);
+	tests.push_back(t);
+	t = new test::Test("load ELF32 executable", test_load_elf);
+	tests.push_back(t);
+	t = new test::Test("load ELF32 executable eagerly", test_load_eager);
+	tests.push_back(t);
+	t = new test::Test("reject truncated segments", test_load_truncated);
+	tests.push_back(t);
+	t = new test::Test("release file-backed memory", test_memory_backings);
+	tests.push_back(t);
+	t = new test::Test("load native image", test_load_image);
+	tests.push_back(t);
+	t = new test::Test("load shared image", test_load_shared);
+	tests.push_back(t);
+	t = new test::Test("load cached assembly", test_load_cached);
+	tests.push_back(t);
+	t = new test::Test("load rv32 assembly", test_load_rv32);
+	tests.push_back(t);
+	t = new test::Test("run rv32 assembly", test_run_rv32);
+	tests.push_back(t);
+	t = new test::Test("write ELF32 executable", test_write_elf);
+	tests.push_back(t);
+	t = new test::Test("write ELF32 executable from source", test_write_elf_from_source);
+	tests.push_back(t);
 
 	return (tests);
 }
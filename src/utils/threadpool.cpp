@@ -0,0 +1,133 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Ours
+#include <threadpool.h>
+#include <config.h>
+
+// Creates a thread pool.
+ThreadPool::ThreadPool(unsigned threads) :
+	stop_(false)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned i = 0; i < threads; i++)
+		workers_.emplace_back(&ThreadPool::work, this);
+}
+
+// Destroys a thread pool.
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stop_ = true;
+	}
+	ready_.notify_all();
+
+	for (std::thread &worker : workers_)
+		worker.join();
+}
+
+// Runs tasks until the pool is shut down.
+void ThreadPool::work(void)
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+
+			ready_.wait(guard, [this] { return (stop_ || !tasks_.empty()); });
+			if (tasks_.empty())
+				return;
+
+			task = std::move(tasks_.front());
+			tasks_.pop();
+		}
+
+		task();
+	}
+}
+
+// Runs a function over a range of indexes.
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &fn)
+{
+	std::mutex lock;
+	std::condition_variable done;
+	std::exception_ptr error;
+	size_t pending = count;
+
+	if (count == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			tasks_.push([&, i] {
+				std::exception_ptr e;
+
+				try
+				{
+					fn(i);
+				}
+				catch (...)
+				{
+					e = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> g(lock);
+				if (e && !error)
+					error = e;
+				if (--pending == 0)
+					done.notify_one();
+			});
+		}
+	}
+	ready_.notify_all();
+
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [&] { return (pending == 0); });
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+// Gets the pool shared by the whole simulator.
+ThreadPool &ThreadPool::instance(void)
+{
+	static ThreadPool pool(VMACHINE_THREADS);
+
+	return (pool);
+}
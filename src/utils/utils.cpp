@@ -22,6 +22,7 @@
 // SOFTWARE.
 //
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -179,3 +180,21 @@ void error(const std::string &msg)
 	std::cerr << msg << std::endl;
 	std::abort();
 }
+
+/**
+ * Hashes the buffer pointed to by @p data one byte at a time, starting
+ * from @p seed, so that hashes of several buffers can be chained.
+ */
+uint64_t hash64(const void *data, size_t size, uint64_t seed)
+{
+	const unsigned char *p = static_cast<const unsigned char *>(data);
+	uint64_t h = seed;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		h ^= p[i];
+		h *= 0x100000001b3ull;
+	}
+
+	return (h);
+}
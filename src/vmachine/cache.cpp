@@ -24,19 +24,180 @@
 
 // Theirs
 #include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // Ours
 #include <vmachine/cache.h>
 
+//==============================================================================
+// Tag Lookup
+//==============================================================================
+
+/**
+ * @brief Matches tags one at a time.
+ */
+static unsigned lookup_scalar(const isa32::word_t *tags, unsigned ways, isa32::word_t tag)
+{
+	unsigned mask = 0;
+
+	for (unsigned i = 0; i < ways; i++)
+	{
+		if (tags[i] == tag)
+			mask |= (1u << i);
+	}
+
+	return (mask);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief Matches tags four at a time.
+ */
+__attribute__((target("sse2")))
+static unsigned lookup_sse2(const isa32::word_t *tags, unsigned ways, isa32::word_t tag)
+{
+	unsigned mask = 0;
+	const __m128i key = _mm_set1_epi32(tag);
+
+	for (unsigned i = 0; i < ways; i += 4)
+	{
+		__m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&tags[i]));
+		__m128i eq = _mm_cmpeq_epi32(t, key);
+		mask |= static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+	}
+
+	return (mask);
+}
+
+/**
+ * @brief Matches tags eight at a time.
+ */
+__attribute__((target("avx2")))
+static unsigned lookup_avx2(const isa32::word_t *tags, unsigned ways, isa32::word_t tag)
+{
+	unsigned mask = 0;
+	const __m256i key = _mm256_set1_epi32(tag);
+
+	for (unsigned i = 0; i < ways; i += 8)
+	{
+		__m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&tags[i]));
+		__m256i eq = _mm256_cmpeq_epi32(t, key);
+		mask |= static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))) << i;
+	}
+
+	return (mask);
+}
+
+#endif
+
+// Selects the fastest tag lookup supported by the host.
+Cache::lookup_fn Cache::select(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		return (lookup_avx2);
+	if (__builtin_cpu_supports("sse2"))
+		return (lookup_sse2);
+#endif
+
+	return (lookup_scalar);
+}
+
+Cache::lookup_fn Cache::lookup_ = Cache::select();
+
+// Forces an implementation of tag lookup.
+bool Cache::setLookupImpl(LookupImpl impl)
+{
+	switch (impl)
+	{
+		case LOOKUP_SCALAR:
+			lookup_ = lookup_scalar;
+			return (true);
+#if defined(__x86_64__) || defined(__i386__)
+		case LOOKUP_SSE2:
+			if (!__builtin_cpu_supports("sse2"))
+				return (false);
+			lookup_ = lookup_sse2;
+			return (true);
+		case LOOKUP_AVX2:
+			if (!__builtin_cpu_supports("avx2"))
+				return (false);
+			lookup_ = lookup_avx2;
+			return (true);
+#endif
+		default:
+			return (false);
+	}
+}
+
+// Gets the implementation of tag lookup in use.
+Cache::LookupImpl Cache::getLookupImpl(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (lookup_ == lookup_avx2)
+		return (LOOKUP_AVX2);
+	if (lookup_ == lookup_sse2)
+		return (LOOKUP_SSE2);
+#endif
+
+	return (LOOKUP_SCALAR);
+}
+
+//==============================================================================
+// Cache
+//==============================================================================
+
 /**
  * @brief Default constructor.
- * 
- * @param size Size of cache memory (in bytes).
+ *
+ * @param size     Size of cache memory (in bytes).
+ * @param ways     Associativity.
+ * @param lineSize Size of a cache line (in bytes).
  */
-Cache::Cache(unsigned size)
+Cache::Cache(unsigned size, unsigned ways, unsigned lineSize)
 {
+	// Sanity check.
+	if ((lineSize == 0) || (lineSize & (lineSize - 1)))
+		throw std::invalid_argument("invalid cache line size");
+	if ((ways == 0) || (ways > MAX_WAYS))
+		throw std::invalid_argument("invalid cache associativity");
+	if ((size == 0) || (size % (ways*lineSize)))
+		throw std::invalid_argument("invalid cache size");
+
 	size_ = size;
-	data = new unsigned [size/sizeof(unsigned)];
+	ways_ = ways;
+	lineSize_ = lineSize;
+	sets_ = size/(ways*lineSize);
+	stride_ = (ways + 7) & ~7u;
+	lineShift_ = __builtin_ctz(lineSize);
+	latency_ = VMACHINE_DEFAULT_CACHE_LATENCY;
+	clock_ = 0;
+	memory_ = nullptr;
+	next_ = nullptr;
+	directory_ = nullptr;
+	id_ = 0;
+	prefetcher_ = nullptr;
+	prefetchStats_ = PrefetchStats();
+	hits_ = 0;
+	misses_ = 0;
+	drops_ = 0;
+
+	// Sanity check.
+	if (sets_ & (sets_ - 1))
+		throw std::invalid_argument("number of cache sets is not a power of two");
+
+	tags = new isa32::word_t[sets_*stride_]();
+	valid = new uint32_t[sets_]();
+	prefetched = new uint32_t[sets_]();
+	invalidated = new uint32_t[sets_]();
+	states = new uint8_t[sets_*ways_]();
+	stamps = new uint32_t[sets_*ways_]();
+	victims = new isa32::word_t[sets_]();
 }
 
 /**
@@ -44,25 +205,406 @@ Cache::Cache(unsigned size)
  */
 Cache::~Cache()
 {
-	delete[] data;
+	delete[] victims;
+	delete[] stamps;
+	delete[] states;
+	delete[] invalidated;
+	delete[] prefetched;
+	delete[] valid;
+	delete[] tags;
+}
+
+// Looks up the way that holds a line.
+int Cache::lookup(unsigned set, isa32::word_t line) const
+{
+	unsigned mask = match(set, line) & valid[set];
+
+	return ((mask == 0) ? -1 : __builtin_ctz(mask));
+}
+
+// Drops the line held in a way.
+void Cache::drop(unsigned set, unsigned way)
+{
+	unsigned i = set*ways_ + way;
+
+	if (directory_ != nullptr)
+		directory_->evict(id_, tags[set*stride_ + way], static_cast<MesiState>(states[i]));
+
+	valid[set] &= ~(1u << way);
+	prefetched[set] &= ~(1u << way);
+	states[i] = MESI_INVALID;
+	drops_++;
+}
+
+// Fills a line in a set, evicting the LRU way.
+unsigned Cache::fill(unsigned set, isa32::word_t line, bool prefetch)
+{
+	unsigned way;
+	uint32_t free = ~valid[set] & ((ways_ == 32) ? ~0u : ((1u << ways_) - 1));
+
+	// Pick an invalid way or else the least recently used one.
+	if (free != 0)
+		way = __builtin_ctz(free);
+	else
+	{
+		const uint32_t *s = &stamps[set*ways_];
+
+		way = 0;
+		for (unsigned i = 1; i < ways_; i++)
+		{
+			if ((clock_ - s[i]) > (clock_ - s[way]))
+				way = i;
+		}
+
+		// Remember demand lines pushed out by prefetches.
+		if (prefetch && !(prefetched[set] & (1u << way)))
+			victims[set] = tags[set*stride_ + way] + 1;
+
+		drop(set, way);
+	}
+
+	tags[set*stride_ + way] = line;
+	valid[set] |= (1u << way);
+	invalidated[set] &= ~(1u << way);
+	if (prefetch)
+		prefetched[set] |= (1u << way);
+	stamps[set*ways_ + way] = ++clock_;
+
+	return (way);
+}
+
+// Issues pending prefetches.
+void Cache::prefetch(void)
+{
+	isa32::word_t line;
+
+	for (unsigned i = 0; (i < VMACHINE_PREFETCH_ISSUE_WIDTH) && queue_.pop(line); i++)
+	{
+		unsigned set = line & (sets_ - 1);
+
+		if (lookup(set, line) >= 0)
+			continue;
+
+		if (next_ != nullptr)
+			next_->prefetchFill(line << lineShift_);
+
+		unsigned way = fill(set, line, true);
+		states[set*ways_ + way] = (directory_ != nullptr) ?
+			directory_->read(id_, line) : MESI_EXCLUSIVE;
+		prefetchStats_.issued++;
+	}
+}
+
+// Fills a line on behalf of a prefetch from the previous level.
+void Cache::prefetchFill(unsigned addr)
+{
+	isa32::word_t line = addr >> lineShift_;
+	unsigned set = line & (sets_ - 1);
+	int way = lookup(set, line);
+
+	if (way >= 0)
+	{
+		stamps[set*ways_ + way] = ++clock_;
+		return;
+	}
+
+	if (next_ != nullptr)
+		next_->prefetchFill(addr);
+
+	way = fill(set, line, false);
+	states[set*ways_ + way] = (directory_ != nullptr) ?
+		directory_->read(id_, line) : MESI_EXCLUSIVE;
+}
+
+// Attaches a hardware prefetcher.
+void Cache::attach(Prefetcher &prefetcher)
+{
+	prefetcher.lineShift_ = lineShift_;
+	prefetcher_ = &prefetcher;
+	queue_.clear();
+}
+
+// Attaches the cache to a coherence directory.
+void Cache::attach(Directory &directory)
+{
+	flush();
+
+	id_ = directory.attach(*this);
+	directory_ = &directory;
+}
+
+// Accesses a line, filling it on a miss.
+bool Cache::access(unsigned addr, isa32::word_t pc, bool write, unsigned *latency)
+{
+	isa32::word_t line = addr >> lineShift_;
+	unsigned set = line & (sets_ - 1);
+	unsigned matches = match(set, line);
+	unsigned hit = matches & valid[set];
+	unsigned cycles = latency_;
+	Prefetcher::Event event;
+
+	if (hit != 0)
+	{
+		unsigned way = __builtin_ctz(hit);
+		uint8_t &state = states[set*ways_ + way];
+
+		hits_++;
+		stamps[set*ways_ + way] = ++clock_;
+
+		// Writes need ownership: shared lines are upgraded.
+		if (write && (state != MESI_MODIFIED))
+		{
+			if ((state == MESI_SHARED) && (directory_ != nullptr))
+				directory_->write(id_, line, true);
+			state = MESI_MODIFIED;
+		}
+
+		event = Prefetcher::HIT;
+		if (prefetched[set] & (1u << way))
+		{
+			prefetched[set] &= ~(1u << way);
+			prefetchStats_.useful++;
+			event = Prefetcher::PREFETCH_HIT;
+		}
+	}
+	else
+	{
+		misses_++;
+
+		if (prefetcher_ != nullptr)
+		{
+			if (queue_.remove(line))
+				prefetchStats_.late++;
+			if (victims[set] == line + 1)
+			{
+				victims[set] = 0;
+				prefetchStats_.polluting++;
+			}
+		}
+
+		if ((directory_ != nullptr) && (matches & invalidated[set]))
+			directory_->coherenceMiss();
+
+		// Miss penalty.
+		if (next_ != nullptr)
+		{
+			unsigned penalty = 0;
+
+			next_->access(addr, pc, false, &penalty);
+			cycles += penalty;
+		}
+		else if (memory_ != nullptr)
+			cycles += memory_->getLatency();
+
+		unsigned way = fill(set, line, false);
+		uint8_t &state = states[set*ways_ + way];
+
+		if (directory_ == nullptr)
+			state = (write) ? MESI_MODIFIED : MESI_EXCLUSIVE;
+		else if (write)
+		{
+			directory_->write(id_, line, false);
+			state = MESI_MODIFIED;
+		}
+		else
+			state = directory_->read(id_, line);
+
+		event = Prefetcher::MISS;
+	}
+
+	// Prefetches go out after the demand access is served.
+	if (prefetcher_ != nullptr)
+	{
+		prefetcher_->train(addr, pc, event, queue_);
+		prefetch();
+	}
+
+	if (latency != nullptr)
+		*latency = cycles;
+
+	return (hit != 0);
+}
+
+// Checks if a line is present.
+bool Cache::probe(unsigned addr) const
+{
+	isa32::word_t line = addr >> lineShift_;
+
+	return (lookup(line & (sets_ - 1), line) >= 0);
+}
+
+// Gets the MESI state of a line.
+MesiState Cache::getState(unsigned addr) const
+{
+	isa32::word_t line = addr >> lineShift_;
+	unsigned set = line & (sets_ - 1);
+	int way = lookup(set, line);
+
+	if (way < 0)
+		return (MESI_INVALID);
+
+	return (static_cast<MesiState>(states[set*ways_ + way]));
+}
+
+// Invalidates a line on behalf of the directory.
+MesiState Cache::snoopInvalidate(isa32::word_t line)
+{
+	unsigned set = line & (sets_ - 1);
+	int way = lookup(set, line);
+
+	if (way < 0)
+		return (MESI_INVALID);
+
+	MesiState state = static_cast<MesiState>(states[set*ways_ + way]);
+
+	valid[set] &= ~(1u << way);
+	prefetched[set] &= ~(1u << way);
+	invalidated[set] |= (1u << way);
+	states[set*ways_ + way] = MESI_INVALID;
+	drops_++;
+
+	return (state);
+}
+
+// Downgrades a line to shared on behalf of the directory.
+MesiState Cache::snoopDowngrade(isa32::word_t line)
+{
+	unsigned set = line & (sets_ - 1);
+	int way = lookup(set, line);
+
+	if (way < 0)
+		return (MESI_INVALID);
+
+	MesiState state = static_cast<MesiState>(states[set*ways_ + way]);
+
+	states[set*ways_ + way] = MESI_SHARED;
+
+	return (state);
+}
+
+// Invalidates a line.
+void Cache::invalidate(unsigned addr)
+{
+	isa32::word_t line = addr >> lineShift_;
+	unsigned set = line & (sets_ - 1);
+	int way = lookup(set, line);
+
+	if (way >= 0)
+		drop(set, way);
+}
+
+// Invalidates all lines.
+void Cache::flush(void)
+{
+	for (unsigned set = 0; set < sets_; set++)
+	{
+		for (uint32_t v = valid[set]; v != 0; v &= v - 1)
+			drop(set, __builtin_ctz(v));
+	}
+
+	queue_.clear();
+}
+
+// Gets the fraction of issued prefetches that were useful.
+double Cache::getPrefetchAccuracy(void) const
+{
+	if (prefetchStats_.issued == 0)
+		return (0.0);
+
+	return (static_cast<double>(prefetchStats_.useful)/prefetchStats_.issued);
+}
+
+// Gets the fraction of would-be misses removed by prefetching.
+double Cache::getPrefetchCoverage(void) const
+{
+	uint64_t total = prefetchStats_.useful + misses_;
+
+	if (total == 0)
+		return (0.0);
+
+	return (static_cast<double>(prefetchStats_.useful)/total);
 }
 
 // Reads a word from the cache.
-unsigned Cache::read(unsigned addr)
+unsigned Cache::read(unsigned addr, isa32::word_t pc, unsigned *latency)
 {
 	// Sanity check.
-	if (addr >= size_)
-		throw std::range_error("invalid cache address");
+	if (memory_ == nullptr)
+		throw std::logic_error("cache is not attached to a memory");
+
+	access(addr, pc, false, latency);
 
-	return (data[addr/sizeof(unsigned)]);
+	return (memory_->read(addr));
 }
 
+//==============================================================================
+// Instruction Cache
+//==============================================================================
+
+// Creates an instruction cache.
+ICache::ICache(unsigned size, unsigned ways, unsigned lineSize) :
+	Cache(size, ways, lineSize)
+{
+	// Sanity check.
+	if (lineSize < sizeof(isa32::word_t))
+		throw std::invalid_argument("invalid cache line size");
+
+	bufferLine_ = 0;
+	bufferSlot_ = 0;
+	bufferDrops_ = 0;
+	bufferValid_ = false;
+	bufferHits_ = 0;
+}
+
+// Fetches an instruction.
+isa32::word_t ICache::fetch(unsigned addr, unsigned *latency)
+{
+	isa32::word_t line = addr >> lineShift_;
+	unsigned cycles = 0;
+
+	// Sanity check.
+	if (memory_ == nullptr)
+		throw std::logic_error("cache is not attached to a memory");
+
+	// Sequential fetches within the buffered line skip the tag lookup.
+	if (bufferValid_ && (line == bufferLine_) && (bufferDrops_ == drops_))
+	{
+		stamps[bufferSlot_] = ++clock_;
+		bufferHits_++;
+	}
+	else
+	{
+		unsigned set = line & (sets_ - 1);
+		int way;
+
+		access(addr, addr, false, &cycles);
+
+		// A prefetch may already have pushed the line out again.
+		way = lookup(set, line);
+		bufferLine_ = line;
+		bufferSlot_ = set*ways_ + way;
+		bufferDrops_ = drops_;
+		bufferValid_ = (way >= 0);
+	}
+
+	if (latency != nullptr)
+		*latency = cycles;
+
+	return (memory_->read(addr));
+}
+
+//==============================================================================
+// Data Cache
+//==============================================================================
+
 // Writes a word from the cache.
-void DCache::write(unsigned addr, unsigned word)
+void DCache::write(unsigned addr, unsigned word, isa32::word_t pc, unsigned *latency)
 {
 	// Sanity check.
-	if (addr >= size_)
-		throw std::range_error("invalid cache address");
+	if (memory_ == nullptr)
+		throw std::logic_error("cache is not attached to a memory");
 
-	data[addr/sizeof(unsigned)] = word;
-}
\ No newline at end of file
+	access(addr, pc, true, latency);
+
+	memory_->write(addr, word);
+}
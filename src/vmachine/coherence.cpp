@@ -0,0 +1,133 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <stdexcept>
+
+// Ours
+#include <vmachine/cache.h>
+#include <vmachine/coherence.h>
+
+// Creates a coherence directory.
+Directory::Directory()
+{
+	ncaches = 0;
+	lineSize_ = 0;
+	stats_ = CoherenceStats();
+}
+
+// Attaches a private cache.
+unsigned Directory::attach(Cache &cache)
+{
+	// Sanity check.
+	if (ncaches == MAX_CACHES)
+		throw std::length_error("too many caches in coherence directory");
+	if ((lineSize_ != 0) && (cache.getLineSize() != lineSize_))
+		throw std::invalid_argument("mismatching line size in coherence directory");
+
+	lineSize_ = cache.getLineSize();
+	caches[ncaches] = &cache;
+
+	return (ncaches++);
+}
+
+// Invalidates a line in all sharers but one.
+void Directory::invalidateOthers(Entry &e, isa32::word_t line, unsigned id)
+{
+	uint32_t others = e.sharers & ~(1u << id);
+
+	// Only actual sharers are visited.
+	while (others != 0)
+	{
+		unsigned i = __builtin_ctz(others);
+
+		others &= others - 1;
+		if (caches[i]->snoopInvalidate(line) == MESI_MODIFIED)
+			stats_.writebacks++;
+		stats_.invalidations++;
+	}
+
+	e.sharers &= (1u << id);
+}
+
+// Handles a read miss.
+MesiState Directory::read(unsigned id, isa32::word_t line)
+{
+	Entry &e = entries[line];
+
+	// First copy in the system.
+	if (e.sharers == 0)
+	{
+		e.sharers = (1u << id);
+		e.owner = id;
+		return (MESI_EXCLUSIVE);
+	}
+
+	// Downgrade the owner.
+	if ((e.owner >= 0) && (static_cast<unsigned>(e.owner) != id))
+	{
+		if (caches[e.owner]->snoopDowngrade(line) == MESI_MODIFIED)
+			stats_.writebacks++;
+		stats_.interventions++;
+	}
+
+	e.owner = -1;
+	e.sharers |= (1u << id);
+
+	return (MESI_SHARED);
+}
+
+// Handles a write miss or an upgrade.
+void Directory::write(unsigned id, isa32::word_t line, bool upgrade)
+{
+	Entry &e = entries[line];
+
+	if (upgrade)
+		stats_.upgrades++;
+
+	invalidateOthers(e, line, id);
+
+	e.sharers = (1u << id);
+	e.owner = id;
+}
+
+// Handles the eviction of a line.
+void Directory::evict(unsigned id, isa32::word_t line, MesiState state)
+{
+	auto it = entries.find(line);
+
+	if (it == entries.end())
+		return;
+
+	if (state == MESI_MODIFIED)
+		stats_.writebacks++;
+
+	it->second.sharers &= ~(1u << id);
+	if (it->second.owner == static_cast<int>(id))
+		it->second.owner = -1;
+
+	// Forget lines that are no longer cached anywhere.
+	if (it->second.sharers == 0)
+		entries.erase(it);
+}
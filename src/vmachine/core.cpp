@@ -33,6 +33,43 @@
 
 using namespace vmachine;
 
+// Decodes the sign-extended immediate of an I-Type instruction.
+static inline isa32::word_t immediateI(isa32::word_t inst)
+{
+	return (static_cast<isa32::word_t>(static_cast<int32_t>(inst) >> 20));
+}
+
+// Decodes the sign-extended immediate of a S-Type instruction.
+static inline isa32::word_t immediateS(isa32::word_t inst)
+{
+	return (
+		(static_cast<isa32::word_t>(static_cast<int32_t>(inst) >> 25) << 5) |
+		((inst >> 7) & 0x1f)
+	);
+}
+
+// Decodes the sign-extended offset of a B-Type instruction.
+static inline isa32::word_t immediateB(isa32::word_t inst)
+{
+	return (
+		static_cast<isa32::word_t>(static_cast<int32_t>(inst & 0x80000000) >> 19) |
+		((inst & 0x80) << 4)                                                       |
+		((inst >> 20) & 0x7e0)                                                     |
+		((inst >> 7) & 0x1e)
+	);
+}
+
+// Decodes the sign-extended offset of a J-Type instruction.
+static inline isa32::word_t immediateJ(isa32::word_t inst)
+{
+	return (
+		static_cast<isa32::word_t>(static_cast<int32_t>(inst & 0x80000000) >> 11) |
+		(inst & 0xff000)                                                           |
+		((inst >> 9) & 0x800)                                                      |
+		((inst >> 20) & 0x7fe)
+	);
+}
+
 // Executes a R-Type instruction.
 void Core::executeR(isa32::word_t inst)
 {
@@ -82,41 +119,41 @@ void Core::executeR(isa32::word_t inst)
 // Executes a I-Type instruction.
 void Core::executeI(isa32::word_t inst)
 {
-	isa32::word_t immediate_1 = ((inst >> INST_SHIFT_IMMEDIATE_I_TYPE) & INST_MASK_IMMEDIATE_I_TYPE);
+	isa32::word_t immediate_1 = immediateI(inst);
 	isa32::word_t rs1         = ((inst >> INST_SHIFT_RS_1)             & INST_MASK_RS_1);
 	isa32::word_t funct_3     = ((inst >> INST_SHIFT_FUNCT_3)          & INST_MASK_FUNCT_3);
 	isa32::word_t rd          = ((inst >> INST_SHIFT_RD)               & INST_MASK_RD);
 	isa32::word_t shamt       = ((inst >> INST_SHIFT_RS_2)             & INST_MASK_RS_2);
 	isa32::word_t opcode      = inst                                   & INST_MASK_OPCODE;
-
-	Cache cache(VMACHINE_DEFAULT_CACHE_SIZE);
+	unsigned latency = 0;
 
 	switch(opcode)
 	{
 		case I_TYPE_JUMPER_INSTRUCTION:
 			if (funct_3 == INST_JALR_FUNCT_3)
 			{
-				registers[rd] = pc + 4;
-				pc += ((registers[rs1] + immediate_1) & (~0u ^ 3u));
+				isa32::word_t target = (registers[rs1] + immediate_1) & ~1u;
+				registers[rd] = pc + sizeof(isa32::word_t);
+				pc = target;
 			}
 		break;
 		case I_TYPE_LOAD_INSTRUCTIONS:
 			if (funct_3 == INST_LB_FUNCT_3)
-				registers[rd] = cache.read(registers[rs1] + immediate_1);
+				registers[rd] = dcache_.read(registers[rs1] + immediate_1, pc, &latency);
 			else if (funct_3 == INST_LH_FUNCT_3)
-				registers[rd] = cache.read(registers[rs1] + immediate_1);
+				registers[rd] = dcache_.read(registers[rs1] + immediate_1, pc, &latency);
 			else if (funct_3 == INST_LW_FUNCT_3)
-				registers[rd] = cache.read(registers[rs1] + immediate_1);
+				registers[rd] = dcache_.read(registers[rs1] + immediate_1, pc, &latency);
 			else if (funct_3 == INST_LBU_FUNCT_3)
-				registers[rd] = cache.read(registers[rs1] + immediate_1);
+				registers[rd] = dcache_.read(registers[rs1] + immediate_1, pc, &latency);
 			else if (funct_3 == INST_LHU_FUNCT_3)
-				registers[rd] = cache.read(registers[rs1] + immediate_1);
+				registers[rd] = dcache_.read(registers[rs1] + immediate_1, pc, &latency);
 		break;
 		case I_TYPE_REGISTERS_INSTRUCTIONS:
 			if (funct_3 == INST_ADDI_FUNCT_3)
 				registers[rd] = registers[rs1] + immediate_1;
 			else if (funct_3 == INST_SLTI_FUNCT_3)
-				registers[rd] = (registers[rs1] < immediate_1) ? 1 : 0;
+				registers[rd] = (static_cast<int32_t>(registers[rs1]) < static_cast<int32_t>(immediate_1)) ? 1 : 0;
 			else if (funct_3 == INST_SLTIU_FUNCT_3)
 				registers[rd] = (registers[rs1] < immediate_1) ? 1 : 0;
 			else if (funct_3 == INST_XORI_FUNCT_3)
@@ -147,6 +184,8 @@ void Core::executeI(isa32::word_t inst)
 		break;
 	}
 
+	cycles_ += latency;
+
 	if (opcode != I_TYPE_JUMPER_INSTRUCTION)
 		pc += sizeof(isa32::word_t);
 }
@@ -155,7 +194,7 @@ void Core::executeI(isa32::word_t inst)
 void Core::executeJ(isa32::word_t inst)
 {
 	isa32::word_t rd      = ((inst >> INST_SHIFT_RD)        & INST_MASK_RD);
-	isa32::word_t address = ((inst >> INST_SHIFT_IMMEDIATE) & INST_MASK_IMMEDIATE);
+	isa32::word_t address = immediateJ(inst);
 	isa32::word_t opcode  = inst                            & INST_MASK_OPCODE;
 
 	switch(opcode)
@@ -173,69 +212,68 @@ void Core::executeJ(isa32::word_t inst)
 // Executes a S-Type instruction.
 void Core::executeS(isa32::word_t inst)
 {
-	isa32::word_t immediate_1 = ((inst >> INST_SHIFT_FUNCT_7) & INST_MASK_FUNCT_7);
+	isa32::word_t immediate_1 = immediateS(inst);
 	isa32::word_t rs2         = ((inst >> INST_SHIFT_RS_2)    & INST_MASK_RS_2);
 	isa32::word_t rs1         = ((inst >> INST_SHIFT_RS_1)    & INST_MASK_RS_1);
 	isa32::word_t funct_3     = ((inst >> INST_SHIFT_FUNCT_3) & INST_MASK_FUNCT_3);
-
-	Memory memory(VMACHINE_DEFAULT_MEMORY_SIZE);
+	unsigned latency = 0;
 
 	switch (funct_3)
 	{
 		case INST_SB_FUNCT_3:
-			memory.write(registers[rs1] + immediate_1, registers[rs2]);
+			dcache_.write(registers[rs1] + immediate_1, registers[rs2], pc, &latency);
 		break;
 		case INST_SH_FUNCT_3:
-			memory.write(registers[rs1] + immediate_1, registers[rs2]);
+			dcache_.write(registers[rs1] + immediate_1, registers[rs2], pc, &latency);
 		break;
 		case INST_SW_FUNCT_3:
-			memory.write(registers[rs1] + immediate_1, registers[rs2]);
+			dcache_.write(registers[rs1] + immediate_1, registers[rs2], pc, &latency);
 		break;
 		default:
 			error("Unknown instruction");
 		break;
 	}
+	cycles_ += latency;
 	pc += sizeof(isa32::word_t);
 }
 
 // Executes a B-Type instruction.
 void Core::executeB(isa32::word_t inst)
 {
-	isa32::word_t immediate_1 = ((inst >> INST_SHIFT_FUNCT_7) & INST_MASK_FUNCT_7);
+	isa32::word_t immediate_1 = immediateB(inst);
 	isa32::word_t rs2         = ((inst >> INST_SHIFT_RS_2)    & INST_MASK_RS_2);
 	isa32::word_t rs1         = ((inst >> INST_SHIFT_RS_1)    & INST_MASK_RS_1);
 	isa32::word_t funct_3     = ((inst >> INST_SHIFT_FUNCT_3) & INST_MASK_FUNCT_3);
+	int32_t lhs = static_cast<int32_t>(registers[rs1]);
+	int32_t rhs = static_cast<int32_t>(registers[rs2]);
+	bool taken = false;
 
 	switch (funct_3)
 	{
 		case INST_BEQ_FUNCT_3:
-			if (registers[rs1] == registers[rs2])
-				pc += immediate_1;
+			taken = (registers[rs1] == registers[rs2]);
 		break;
 		case INST_BNE_FUNCT_3:
-			if (registers[rs1] != registers[rs2])
-				pc += immediate_1;
+			taken = (registers[rs1] != registers[rs2]);
 		break;
 		case INST_BLT_FUNCT_3:
-			if (registers[rs1] < registers[rs2])
-				pc += immediate_1;
+			taken = (lhs < rhs);
 		break;
 		case INST_BGE_FUNCT_3:
-			if (registers[rs1] >= registers[rs2])
-				pc += immediate_1;
+			taken = (lhs >= rhs);
 		break;
 		case INST_BLTU_FUNCT_3:
-			if (registers[rs1] < registers[rs2])
-				pc += immediate_1;
+			taken = (registers[rs1] < registers[rs2]);
 		break;
 		case INST_BGEU_FUNCT_3:
-			if (registers[rs1] >= registers[rs2])
-				pc += immediate_1;
+			taken = (registers[rs1] >= registers[rs2]);
 		break;
 		default:
 			error("Unknown instruction");
 		break;
 	}
+
+	pc += taken ? immediate_1 : sizeof(isa32::word_t);
 }
 
 // Executes a U-Type instruction.
@@ -312,29 +350,35 @@ void Core::execute(isa32::word_t inst)
 	auto execute = decode(inst);
 
 	(this->*execute)(inst);
+
+	// Register zero is hardwired.
+	registers[0] = 0;
+
+	cycles_ += latency_;
+	instret_++;
 }
 
 // Fetches an instruction.
 isa32::word_t Core::fetch(void)
 {
 	isa32::word_t inst;
+	unsigned latency = 0;
 
-	inst = memory_.read(pc);
+	inst = icache_.fetch(pc, &latency);
+	cycles_ += latency;
 
 	return (inst);
 }
 
+// Fetches and executes the next instruction.
+void Core::step(void)
+{
+	execute(fetch());
+}
+
 // Runs the target core.
 void Core::run(void)
 {
 	while (true)
-	{
-		isa32::word_t inst;
-
-		inst = fetch();
-
-		execute(inst);
-
-		pc += sizeof(isa32::word_t);
-	}
+		step();
 }
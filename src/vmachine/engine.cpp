@@ -94,8 +94,8 @@ using namespace std;
 #define check_sub_funct(x) (x == INST_FUNCT_SUB) || (x == INST_FUNCT_SUBU)
 #define check_logic(k) (k == INST_FUNCT_AND || k == INST_FUNCT_NOR || k == INST_FUNCT_OR)
 #define check_addsub(x) check_add_funct(x) | check_sub_funct(x)
-#define check_shamtRd(x) (x == 0x00 && (mips32_r_instruction.getRd().getCode() == NIL))
-#define check_shamt(x) (x == 0x00 && (mips32_r_instruction.getRt().getCode() == NIL && mips32_r_instruction.getRd().getCode() == NIL))
+#define check_shamtRd(t, x) (x == 0x00 && (t.mips32_r_instruction.getRd().getCode() == NIL))
+#define check_shamt(t, x) (x == 0x00 && (t.mips32_r_instruction.getRt().getCode() == NIL && t.mips32_r_instruction.getRd().getCode() == NIL))
 #define check_shift(x) (x==INST_FUNCT_SLL || x==INST_FUNCT_SRL || x==INST_FUNCT_SRA)
 #define check_conJump(x) (x==INST_FUNCT_SLT || x==INST_FUNCT_SLTU)
 #define check_div(x) (x==INST_FUNCT_DIV || x==INST_FUNCT_DIVU)
@@ -130,12 +130,22 @@ const isa32::word_t registers32[MIPS32_REGISTERS] = {
 	REG_RA,
 };
 
+/**
+ * Check if an instruction reads or writes a register.
+ * @param r   MIPS32 instruction
+ * @param reg Register code
+ */
+static bool uses_register(Rformat &r, isa32::word_t reg)
+{
+	return (r.getRs().getCode() == reg || r.getRt().getCode() == reg || r.getRd().getCode() == reg);
+}
+
 /**
  * Check if these two parameters are equals.
  * @param tk1
  * @param tk2
  * */
-void Engine::match(isa32::word_t token1,isa32::word_t token2)
+void Engine::match(isa32::word_t token1,isa32::word_t token2) const
 {
     if(token1 != token2)
     {
@@ -146,144 +156,148 @@ void Engine::match(isa32::word_t token1,isa32::word_t token2)
 /*
 * r_procedure_D();
 */
-void Engine::r_procedure_D()
+void Engine::r_procedure_D(Translation &t) const
 {
-    if(mips32_r_instruction.getInstruction().getShamt() == 0x00)
+    if(t.mips32_r_instruction.getInstruction().getShamt() == 0x00)
 	{
-		match(mips32_r_instruction.getInstruction().getShamt(),0x00);
+		match(t.mips32_r_instruction.getInstruction().getShamt(),0x00);
 	}else
 	{
-		match(mips32_r_instruction.getSa().getCode(),registers32[mips32_r_instruction.getSa().getCode()]);
+		match(t.mips32_r_instruction.getSa().getCode(),registers32[t.mips32_r_instruction.getSa().getCode()]);
 
 		// Rule [23] {D_sa := sa.lex}
-		D_sa = mips32_r_instruction.getSa().getCode();
+		t.D_sa = t.mips32_r_instruction.getSa().getCode();
 
 		//[25] {rv_instructionAdd := “bin_n(D_sa) + "00000 000" + (register) 0010011”}
 		// [CHECK ME]
-		rv_instructionAdd |= (D_sa & 0x0000fff) << 20;
-		rv_instructionAdd |= (0x00 & 0x000007f) << 15;
-		rv_instructionAdd |= (0x00 & 0x0000007) << 12;
-		rv_instructionAdd |= (use_register & 0x000001f) << 7;
-		rv_instructionAdd |= (0x13 & 0x000007f) << 0;		
+		t.rv_instructionAdd = 0;
+		t.rv_instructionAdd |= (t.D_sa & 0x0000fff) << 20;
+		t.rv_instructionAdd |= (0x00 & 0x000007f) << 15;
+		t.rv_instructionAdd |= (0x00 & 0x0000007) << 12;
+		t.rv_instructionAdd |= (t.use_register & 0x000001f) << 7;
+		t.rv_instructionAdd |= (0x13 & 0x000007f) << 0;
 	}
 }
 
 /*
 * r_procedure_C();
 */
-void Engine::r_procedure_C()
+void Engine::r_procedure_C(Translation &t) const
 {
-    if(check_shamtRd(mips32_r_instruction.getInstruction().getShamt()))
+    if(check_shamtRd(t, t.mips32_r_instruction.getInstruction().getShamt()))
 	{
-		match(mips32_r_instruction.getInstruction().getShamt(),0x00);
+		match(t.mips32_r_instruction.getInstruction().getShamt(),0x00);
 	}else
 	{
-		match(mips32_r_instruction.getRd().getCode(),registers32[mips32_r_instruction.getRd().getCode()]);
+		match(t.mips32_r_instruction.getRd().getCode(),registers32[t.mips32_r_instruction.getRd().getCode()]);
 
 		// Rule [21] {C_rd := rd.lex}
-		C_rd = mips32_r_instruction.getRd().getCode();
+		t.C_rd = t.mips32_r_instruction.getRd().getCode();
 
-		r_procedure_D();
+		r_procedure_D(t);
 	}
 }
 
 /*
 * r_procedure_B();
 */
-void Engine::r_procedure_B()
+void Engine::r_procedure_B(Translation &t) const
 {
-	if(check_shamt(mips32_r_instruction.getInstruction().getShamt()))
+	if(check_shamt(t, t.mips32_r_instruction.getInstruction().getShamt()))
 	{
-		match(mips32_r_instruction.getInstruction().getShamt(),0x00);
+		match(t.mips32_r_instruction.getInstruction().getShamt(),0x00);
 	}else
 	{
 		
-		match(mips32_r_instruction.getRt().getCode(),registers32[mips32_r_instruction.getRt().getCode()]);
+		match(t.mips32_r_instruction.getRt().getCode(),registers32[t.mips32_r_instruction.getRt().getCode()]);
 
 		// Rule [22] {B_rt := rt.lex}
-		B_rt = mips32_r_instruction.getRt().getCode();
+		t.B_rt = t.mips32_r_instruction.getRt().getCode();
 
-		r_procedure_C();
+		r_procedure_C(t);
 	}
 }
 
 /*
 * r_procefure_Format()
 */
-void Engine::r_procedure_Format()
+void Engine::r_procedure_Format(Translation &t) const
 {
 
-	match(mips32_r_instruction.getRs().getCode(),registers32[mips32_r_instruction.getRs().getCode()]);
+	match(t.mips32_r_instruction.getRs().getCode(),registers32[t.mips32_r_instruction.getRs().getCode()]);
  
 	// Rule [19] {Format_rs := rs.lex} 
-	Format_rs = mips32_r_instruction.getRs().getCode();
+	t.Format_rs = t.mips32_r_instruction.getRs().getCode();
 
-	r_procedure_B();
+	r_procedure_B(t);
 } 
 
 /**
  * r_pocedure_Sum(); 
  */
-void Engine::r_procedure_Sum()
+void Engine::r_procedure_Sum(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_ADD)
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_ADD)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_ADD);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_ADD);
 	}else
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_ADDU);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_ADDU);
 	}
 
 	// Rule [1] {Sum.funct7 := “0000000”, Sum.funct3 := “000”}
-	Sum_funct7 = 0x00;
-	Sum_funct3 = 0x00;
+	isa32::word_t Sum_funct7 = 0x00;
+	isa32::word_t Sum_funct3 = 0x00;
 
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}	
-	rv_instruction = 0;
-	rv_instruction |= (Sum_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (Sum_funct3 & 0x0000007) << 12;
-	rv_instruction |= (C_rd & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;
+	t.rv_instruction |= (Sum_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (Sum_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.C_rd & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 
 }
 
 /**
  * r_pocedure_Sub(); 
  */
-void Engine::r_procedure_Sub()
+void Engine::r_procedure_Sub(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SUB)
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SUB)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SUB);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SUB);
 	}else
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SUBU);		
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SUBU);		
 	}
 
 	// Rule [4] {Sub.funct7 := “”, Sub.funct3 := “000”}
-	Sub_funct7 = 0x20;
-	Sub_funct3 = 0x00;
+	isa32::word_t Sub_funct7 = 0x20;
+	isa32::word_t Sub_funct3 = 0x00;
 	
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;	
-	rv_instruction |= (Sub_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (Sub_funct3 & 0x0000007) << 12;
-	rv_instruction |= (C_rd & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;	
+	t.rv_instruction |= (Sub_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (Sub_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.C_rd & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 }
 
 /**
  * r_pocedure_Div(); 
  */
-void Engine::r_procedure_Div()
+void Engine::r_procedure_Div(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_DIV)
+	isa32::word_t Div_funct7;
+	isa32::word_t Div_funct3;
+
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_DIV)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_DIV);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_DIV);
 
 		// Rule [5] {Div.funct7 := “0000001”, Div.funct3 := “100”}
 		Div_funct7 = 0x01;
@@ -291,7 +305,7 @@ void Engine::r_procedure_Div()
 	
 	}else
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_DIVU);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_DIVU);
 
 		// Rule [6] {Div.funct7 := “0000001”, Div.funct3 := “101”}
 		Div_funct7 = 0x01; 
@@ -299,97 +313,102 @@ void Engine::r_procedure_Div()
 	}
 	
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;	
-	rv_instruction |= (Div_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (Div_funct3 & 0x0000007) << 12;
-	rv_instruction |= (use_register & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;	
+	t.rv_instruction |= (Div_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (Div_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.use_register & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 
 	// Rule [28] {rv_instructionAddi := 00000000000000000000 + (use_register) + 0010011}
 	// Clean register using instruction [addi $use_register,x0,0x00]
 	// [CHECK ME]
-	rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
-	rv_instructionAddi |= (use_register & 0x000001f) << 7;
-	rv_instructionAddi |= (0x13 & 0x000007f) << 0;
+	t.rv_instructionAddi = 0;
+	t.rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
+	t.rv_instructionAddi |= (t.use_register & 0x000001f) << 7;
+	t.rv_instructionAddi |= (0x13 & 0x000007f) << 0;
 }
 
 /**
  * r_pocedure_Mult();
  */
-void Engine::r_procedure_Mult()
+void Engine::r_procedure_Mult(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_MULT)
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_MULT)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_MULT);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_MULT);
 	}else
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_MULTU);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_MULTU);
 	}
 
 	// Rule [7] {Mult.funct7 := “0000001”, Mult.funct3 := “000”}
-	Mult_funct7 = 0x01;
-	Mult_funct3 = 0x00;
+	isa32::word_t Mult_funct7 = 0x01;
+	isa32::word_t Mult_funct3 = 0x00;
 
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;	
-	rv_instruction |= (Mult_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (Mult_funct3 & 0x0000007) << 12;
-	rv_instruction |= (use_register & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;	
+	t.rv_instruction |= (Mult_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (Mult_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.use_register & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 
 	// Rule [28] {rv_instructionAddi := 00000000000000000000 + (use_register) + 0010011}
 	// Clean register using instruction [addi $use_register,x0,0x00]
 	// [CHECK ME]
-	rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
-	rv_instructionAddi |= (use_register & 0x000001f) << 7;
-	rv_instructionAddi |= (0x13 & 0x000007f) << 0;
+	t.rv_instructionAddi = 0;
+	t.rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
+	t.rv_instructionAddi |= (t.use_register & 0x000001f) << 7;
+	t.rv_instructionAddi |= (0x13 & 0x000007f) << 0;
 }
 
 /**
  * r_procedure_UncJump();
  */
-void Engine::r_procedure_UncJump()
+void Engine::r_procedure_UncJump(Translation &t) const
 {
-	match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_JR);
+	match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_JR);
 
 	// Rule [26] {UncJump_funct3 = "000"}
-	UncJump_funct3 = 0x00;
+	isa32::word_t UncJump_funct3 = 0x00;
 
 	// Rule [27] {rv_instruction := 00000000000000000000 + 00000(x0 = $zero) + 000 11111(x1 = ra) + opcode}
-	rv_instruction = 0;
-	rv_instruction |= (0x00 & 0x0000fff) << 20;
-	rv_instruction |= (0x00 & 0x000001f) << 15;
-	rv_instruction |= (UncJump_funct3 & 0x000007) << 12;
-	rv_instruction |= (Format_rs & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;
+	t.rv_instruction |= (0x00 & 0x0000fff) << 20;
+	t.rv_instruction |= (0x00 & 0x000001f) << 15;
+	t.rv_instruction |= (UncJump_funct3 & 0x000007) << 12;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 }
 
 /**
  * r_procedure_Logic();
  */
-void Engine::r_procedure_Logic()
+void Engine::r_procedure_Logic(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_AND)
+	isa32::word_t Logic_funct7 = 0x00;
+	isa32::word_t Logic_funct3 = 0x00;
+
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_AND)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_AND);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_AND);
 
 		// Rule [8] {Logic.funct7 := “0000000”, Logic.funct3 := “111”}
 		Logic_funct7 = 0x00; 
 		Logic_funct3 = 0x07;
-	}else if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_NOR)
+	}else if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_NOR)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_NOR);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_NOR);
 
 		// Rule [9] {Logic.funct7 := “0000000”, Logic.funct3 := “000”}
 		Logic_funct7 = 0x00;
 		Logic_funct3 = 0x00;
-	}else if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_OR)
+	}else if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_OR)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_OR);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_OR);
 
 		// Rule [10] {Logic.funct7 := “0000000”, Logic.funct3 := “110”}
 		Logic_funct7 = 0x00;
@@ -397,51 +416,54 @@ void Engine::r_procedure_Logic()
 	}
 
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;
-	rv_instruction |= (Logic_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (Logic_funct3 & 0x0000007) << 12;
-	rv_instruction |= (C_rd & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;
+	t.rv_instruction |= (Logic_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (Logic_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.C_rd & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 
 }
 
 /**
  * r_pocedure_Arithmetic();
  */
-void Engine::r_procedure_Arithmetic()
+void Engine::r_procedure_Arithmetic(Translation &t) const
 {
-	if(check_add_funct(mips32_r_instruction.getInstruction().getFunct()))
+	if(check_add_funct(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Sum();
-	}else if(check_sub_funct(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Sum(t);
+	}else if(check_sub_funct(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Sub();
-	}else if(check_div(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Sub(t);
+	}else if(check_div(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Div();
-	}else if(check_mul(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Div(t);
+	}else if(check_mul(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Mult();
+		r_procedure_Mult(t);
 	}
 }
 
 /**
  * r_procedure_ConJump();
  */
-void Engine::r_procedure_ConJump()
+void Engine::r_procedure_ConJump(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLT)
+	isa32::word_t ConJump_funct7 = 0x00;
+	isa32::word_t ConJump_funct3 = 0x00;
+
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLT)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLT);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLT);
 
 		// Rule [11] {ConJump.funct7 := “0000000”, ConJump.funct3 := “010”}
 		ConJump_funct7 = 0x00;
 		ConJump_funct3 = 0x02;
-	}else if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLTU)
+	}else if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLTU)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLTU);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLTU);
 		
 		// Rule [12] {ConJump.funct7 := “0000000”, ConJump.funct3 := “011’”}
 		ConJump_funct7 = 0x00;
@@ -449,37 +471,40 @@ void Engine::r_procedure_ConJump()
 	}
 
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;	
-	rv_instruction |= (ConJump_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (Format_rs & 0x000001f) << 15;
-	rv_instruction |= (ConJump_funct3 & 0x0000007) << 12;
-	rv_instruction |= (C_rd & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;	
+	t.rv_instruction |= (ConJump_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.Format_rs & 0x000001f) << 15;
+	t.rv_instruction |= (ConJump_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.C_rd & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 }
 
 /**
  * r_procedure_Shift(); 
  */
-void Engine::r_procedure_Shift()
+void Engine::r_procedure_Shift(Translation &t) const
 {
-	if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLL)
+	isa32::word_t Shift_funct7 = 0x00;
+	isa32::word_t Shift_funct3 = 0x00;
+
+	if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SLL)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLL);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SLL);
 
 		// Rule [13] {Shift.funct7 := “0000000”, Shift.funct3 := “001”}
 		Shift_funct7 = 0x00;
 		Shift_funct3 = 0x01;
-	}else if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SRL)
+	}else if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SRL)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SRL);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SRL);
 
 		// Rule [14] {Shift.funct7 := “0000000”, Shift.funct3 := “101”}
 		Shift_funct7 = 0x00;
 		Shift_funct3 = 0x05;
-	}else if(mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SRA)
+	}else if(t.mips32_r_instruction.getInstruction().getFunct() == INST_FUNCT_SRA)
 	{
-		match(mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SRA);
+		match(t.mips32_r_instruction.getInstruction().getFunct(),INST_FUNCT_SRA);
 
 		// Rule [15] {Shift.funct7 := “0100000”, Shift.funct3 := “110”}
 		Shift_funct7 = 0x20;
@@ -487,81 +512,82 @@ void Engine::r_procedure_Shift()
 	}
 	
 	// Rule [24] {rv_instruction := funct7 + rs2 + rs + funct3 + rd + opcode}
-	rv_instruction = 0;	
-	rv_instruction |= (Shift_funct7 & 0x000007f) << 25;
-	rv_instruction |= (B_rt & 0x000001f) << 20;
-	rv_instruction |= (use_register & 0x000001f) << 15;
-	rv_instruction |= (Shift_funct3 & 0x0000007) << 12;
-	rv_instruction |= (C_rd & 0x000001f) << 7;
-	rv_instruction |= (S_opcode & 0x000007f) << 0;
+	t.rv_instruction = 0;	
+	t.rv_instruction |= (Shift_funct7 & 0x000007f) << 25;
+	t.rv_instruction |= (t.B_rt & 0x000001f) << 20;
+	t.rv_instruction |= (t.use_register & 0x000001f) << 15;
+	t.rv_instruction |= (Shift_funct3 & 0x0000007) << 12;
+	t.rv_instruction |= (t.C_rd & 0x000001f) << 7;
+	t.rv_instruction |= (t.S_opcode & 0x000007f) << 0;
 
 
 	// Rule [28] {rv_instructionAddi := 00000000000000000000 + (use_register) + 0010011}
 	// Clean register using instruction [addi $use_register,x0,0x00]
 	// [CHECK ME]
-	rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
-	rv_instructionAddi |= (use_register & 0x000001f) << 7;
-	rv_instructionAddi |= (0x13 & 0x000007f) << 0;
+	t.rv_instructionAddi = 0;
+	t.rv_instructionAddi |= (0x00 & 0x00fffff) << 12;
+	t.rv_instructionAddi |= (t.use_register & 0x000001f) << 7;
+	t.rv_instructionAddi |= (0x13 & 0x000007f) << 0;
 }
 
 /**
  * r_pocedure_Function(); 
  */
-void Engine::r_procedure_Function()
+void Engine::r_procedure_Function(Translation &t) const
 {
 
-	if(check_addsub(mips32_r_instruction.getInstruction().getFunct()) | check_divmul(mips32_r_instruction.getInstruction().getFunct()))
+	if(check_addsub(t.mips32_r_instruction.getInstruction().getFunct()) | check_divmul(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Arithmetic();
-	}else if(check_jr_format(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Arithmetic(t);
+	}else if(check_jr_format(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_UncJump();
-	}else if(check_logic(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_UncJump(t);
+	}else if(check_logic(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Logic();
-	}else if(check_shift(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Logic(t);
+	}else if(check_shift(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_Shift();
-	}else if(check_conJump(mips32_r_instruction.getInstruction().getFunct()))
+		r_procedure_Shift(t);
+	}else if(check_conJump(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		r_procedure_ConJump();
+		r_procedure_ConJump(t);
 	}
 }
 
 /*
 * First rule of grammar and Parsing tree
 */
-void Engine::r_procedure_S()
+void Engine::r_procedure_S(Translation &t) const
 {
-	match(mips32_r_instruction.getInstruction().getOpcode(),0x00);
+	match(t.mips32_r_instruction.getInstruction().getOpcode(),0x00);
 
 	// Rule [0] {se funct = "" entao S.opcode := "1100111" senao S.opcode := “0110011”}
-	if(mips32_r_instruction.getInstruction().getFunct() == 0x08)
+	if(t.mips32_r_instruction.getInstruction().getFunct() == 0x08)
 	{
-		S_opcode = 0x67;
+		t.S_opcode = 0x67;
 	}else
 	{
-		S_opcode = 0x33;
+		t.S_opcode = 0x33;
 	}
-	r_procedure_Format();
-	r_procedure_Function();
+	r_procedure_Format(t);
+	r_procedure_Function(t);
 }
 
 /**
  * Translate binary code MIPS32 in RV32.
  * Opening process of translate
  */
-void Engine::r_translator()
+void Engine::r_translator(Translation &t) const
 {
-	if(mips32_r_instruction.getRd().getCode() != NIL && mips32_r_instruction.getRd().getCode() == registers32[12])
-	{
-		flag_use_t4 = true;
-	}else if(mips32_r_instruction.getRd().getCode() != NIL && mips32_r_instruction.getRd().getCode() == registers32[13])
+	t.flag_use_t4 = uses_register(t.mips32_r_instruction, registers32[12]);
+	t.flag_use_t5 = uses_register(t.mips32_r_instruction, registers32[13]);
+
+	if(check_shift(t.mips32_r_instruction.getInstruction().getFunct()) || check_divmul(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		flag_use_t5 = true;
+		register_management(t);
 	}
 
-	r_procedure_S();
+	r_procedure_S(t);
 }
 
 /**
@@ -570,7 +596,7 @@ void Engine::r_translator()
  * and redirects for each function corresponding
  * @param word_inst MIPS instruction of 32 bits
  */
-void Engine::selectInstruction(isa32::word_t word_inst)
+void Engine::selectInstruction(Translation &t, isa32::word_t word_inst) const
 {
 	Mips32Instruction instruction = Mips32Instruction();
 
@@ -579,154 +605,152 @@ void Engine::selectInstruction(isa32::word_t word_inst)
 
 	if(check_main_format(instruction.getFunct()))
 	{ 
-		mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
-		mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
-		mips32_r_instruction.setRd(Mips32Register(((word_inst >> INST_SHIFT_RD) & INST_MASK_RD)));
+		t.mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
+		t.mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
+		t.mips32_r_instruction.setRd(Mips32Register(((word_inst >> INST_SHIFT_RD) & INST_MASK_RD)));
 		instruction.setShamt(((word_inst >> INST_SHIFT_SHAMT) & INST_MASK_SHAMT));
 	}else if(check_jr_format(instruction.getFunct()))
 	{	
-		mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
-		mips32_r_instruction.setRd(Mips32Register());
-		mips32_r_instruction.setRt(Mips32Register());
+		t.mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
+		t.mips32_r_instruction.setRd(Mips32Register());
+		t.mips32_r_instruction.setRt(Mips32Register());
 		instruction.setShamt(((word_inst >> INST_SHIFT_SHAMT) & INST_MASK_SHAMT_JR));
 	}else if(check_shift_format(instruction.getFunct()))
 	{
-		mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
-		mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
-		mips32_r_instruction.setRd(Mips32Register(((word_inst >> INST_SHIFT_RD) & INST_MASK_RD)));
-		mips32_r_instruction.setSa(Mips32Register(((word_inst >> INST_SHIFT_SA) & INST_MASK_SA)));
-		register_management();
+		t.mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
+		t.mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
+		t.mips32_r_instruction.setRd(Mips32Register(((word_inst >> INST_SHIFT_RD) & INST_MASK_RD)));
+		t.mips32_r_instruction.setSa(Mips32Register(((word_inst >> INST_SHIFT_SA) & INST_MASK_SA)));
 	}else if(check_divmul_format(instruction.getFunct()))
 	{
-		mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
-		mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
-		mips32_r_instruction.setRd(Mips32Register());
+		t.mips32_r_instruction.setRs(Mips32Register(((word_inst >> INST_SHIFT_RS) & INST_MASK_RS)));
+		t.mips32_r_instruction.setRt(Mips32Register(((word_inst >> INST_SHIFT_RT) & INST_MASK_RT)));
+		t.mips32_r_instruction.setRd(Mips32Register());
 		instruction.setShamt(((word_inst >> INST_SHIFT_SHAMT) & INST_MASK_SHAMT));
-		register_management();
 	}
 
-	mips32_r_instruction.setInstruction(instruction);
-	r_translator();
+	t.mips32_r_instruction.setInstruction(instruction);
+	r_translator(t);
 }
 
 /**
  * Make the management of the special 
  * registers in MIPS32 $t4 and $t5 
  */
-void Engine::register_management()
+void Engine::register_management(Translation &t) const
 {
-	if(flag_use_t4 && flag_use_t5)
+	if(t.flag_use_t4 && t.flag_use_t5)
 	{
-		flag_use_t4_t5 = true;
-		use_register = registers32[13];
+		t.flag_use_t4_t5 = true;
+		t.use_register = registers32[13];
 	
 		// [FIX ME]
 		/**
 		 * MIPS32:[sub $sp,$sp,4]   - RV32:[addi x2,x2,-4]
 		 * MIPS32:[sw $t5,0($sp)]   - RV32:[sw x30,0(x2)]
 		*/
-		instructions_set[0] = 0xffce8e93;
-		instructions_set[1] = 0xdea023;
+		t.instructions_set[0] = 0xffce8e93;
+		t.instructions_set[1] = 0xdea023;
 
 		/**
  		 * MIPS32:[lw $t5,0($sp)]   - RV32:[lw $x30,0(x2)]
 		 * MIPS32:[sw $zero,0($sp)] - RV32:[sw $zero,0(x2)]
 		 * MIPS32:[addi $sp,$sp,4]  - RV32:[addi x2,x2,4]
 		*/
-		instructions_set[2] = 0xea683;
-		instructions_set[4] = 0xea023;
-		instructions_set[5] = 0xe8e93;
-	}else if(flag_use_t5)
+		t.instructions_set[2] = 0xea683;
+		t.instructions_set[3] = 0xea023;
+		t.instructions_set[4] = 0xe8e93;
+	}else if(t.flag_use_t5)
 	{
-		use_register = registers32[12];
+		t.use_register = registers32[12];
 	}else
 	{
-		use_register = registers32[13];
+		t.use_register = registers32[13];
 	}
 }
 
 /*
  * Make merge in the instructions to a instructions buffer. 
  */
-isa32::word_t *Engine::getBuffer()
+TranslationBuffer Engine::getBuffer(Translation &t) const
 {	
-	isa32::word_t *buffer = NULL;
+	TranslationBuffer buffer;
 
-	if(check_shift(mips32_r_instruction.getInstruction().getFunct()))
+	if(check_shift(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-		switch (flag_use_t4_t5)
+		switch (t.flag_use_t4_t5)
 		{
 			case true:
-				buffer = (isa32::word_t *)malloc(9*sizeof(isa32::word_t));
-			
 			// [CHECK ME]
-			//	buffer[0] = instructions_set[0]; 
-			//	buffer[1] = instructions_set[1];
-			//	buffer[2] = rv_instructionAdd;
-				buffer[0] = rv_instruction;
-			//	buffer[4] = rv_instructionAddi;
-			//	buffer[5] = instructions_set[2];
-			//	buffer[6] = instructions_set[4];
-			//	buffer[7] = instructions_set[5];
-				buffer[1] = RV32_NOP;
+			//	buffer.push(t.instructions_set[0]);
+			//	buffer.push(t.instructions_set[1]);
+			//	buffer.push(t.rv_instructionAdd);
+				buffer.push(t.rv_instruction);
+			//	buffer.push(t.rv_instructionAddi);
+			//	buffer.push(t.instructions_set[2]);
+			//	buffer.push(t.instructions_set[3]);
+			//	buffer.push(t.instructions_set[4]);
+				buffer.push(RV32_NOP);
 			break;
 
 			default:
-				buffer = (isa32::word_t *)malloc(4*sizeof(isa32::word_t));
-
-				//buffer[0] = rv_instructionAdd;
-				buffer[0] = rv_instruction;
-				buffer[2] = rv_instructionAddi;
-				buffer[3] = RV32_NOP;
+				//buffer.push(t.rv_instructionAdd);
+				buffer.push(t.rv_instruction);
+				buffer.push(t.rv_instructionAddi);
+				buffer.push(RV32_NOP);
 			break;
 		}	
-	}else if(check_divmul(mips32_r_instruction.getInstruction().getFunct()))
+	}else if(check_divmul(t.mips32_r_instruction.getInstruction().getFunct()))
 	{
-	
-
-		switch (flag_use_t4_t5)
+		switch (t.flag_use_t4_t5)
 		{
 			case true:
-				buffer = (isa32::word_t *)malloc(8*sizeof(isa32::word_t));
-
 				// [CHECK ME]
-			//	buffer[0] = instructions_set; 
-			//	buffer[1] = instructions_set[1];
-				buffer[0] = rv_instruction;
-			//	buffer[1] = rv_instructionAddi;
-			//	buffer[4] = instructions_set[2];
-			//	buffer[5] = instructions_set[4];
-			//	buffer[6] = instructions_set[5];
-				buffer[1] = RV32_NOP;
+			//	buffer.push(t.instructions_set[0]);
+			//	buffer.push(t.instructions_set[1]);
+				buffer.push(t.rv_instruction);
+			//	buffer.push(t.rv_instructionAddi);
+			//	buffer.push(t.instructions_set[2]);
+			//	buffer.push(t.instructions_set[3]);
+			//	buffer.push(t.instructions_set[4]);
+				buffer.push(RV32_NOP);
 				break;
 
 			default:
-				buffer = (isa32::word_t *)malloc(3*sizeof(isa32::word_t));
-				
-				buffer[0] = rv_instruction;
-				buffer[1] = rv_instructionAddi;
-				buffer[2] = RV32_NOP;
+				buffer.push(t.rv_instruction);
+				buffer.push(t.rv_instructionAddi);
+				buffer.push(RV32_NOP);
 				break;
 		}
 	}else
 	{
-		buffer = (isa32::word_t *)malloc(2*sizeof(isa32::word_t));
-
-		buffer[0] = rv_instruction;
-		buffer[1] = RV32_NOP;
+		buffer.push(t.rv_instruction);
+		buffer.push(RV32_NOP);
 	}
 
 	return buffer;
 }
 
+/**
+ * Translate a MIPS32 instruction. Every call starts
+ * from a fresh Translation, so the result depends on
+ * the instruction only.
+ */
+Translation Engine::translate(isa32::word_t instruction) const
+{
+	Translation t;
+
+	selectInstruction(t, instruction);
+
+	return t;
+}
+
 /**	
  * The engine_run() function translates a binary code into another.
  */
-isa32::word_t Engine::engine_run(uint32_t instruction)
+isa32::word_t Engine::engine_run(uint32_t instruction) const
 {
-	selectInstruction(instruction);
-
-	isa32::word_t *buffer = getBuffer();
+	Translation t = translate(instruction);
 
-	return buffer[0];
+	return getBuffer(t).words[0];
 }
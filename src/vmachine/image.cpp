@@ -0,0 +1,549 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Ours
+#include <asm/mips32.h>
+#include <vmachine/image.h>
+
+using namespace vmachine;
+
+// Reads exactly a range of a file.
+static void readAt(int fd, void *buf, size_t size, off_t offset)
+{
+	if (pread(fd, buf, size, offset) != static_cast<ssize_t>(size))
+		throw std::invalid_argument("truncated ELF file");
+}
+
+// Asserts that an ELF header describes a loadable executable.
+void vmachine::checkElf(const Elf32_Ehdr &ehdr)
+{
+	if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0)
+		throw std::invalid_argument("not an ELF file");
+	if ((ehdr.e_ident[EI_CLASS] != ELFCLASS32) || (ehdr.e_ident[EI_DATA] != ELFDATA2LSB))
+		throw std::invalid_argument("not a little-endian ELF32 file");
+	if ((ehdr.e_type != ET_EXEC) || (ehdr.e_machine != EM_RISCV))
+		throw std::invalid_argument("not a RISC-V executable");
+	if (ehdr.e_phentsize != sizeof(Elf32_Phdr))
+		throw std::invalid_argument("invalid program header size");
+}
+
+// Reads the symbol table of an ELF32 file.
+std::vector<Image::Symbol> vmachine::readElfSymbols(int fd, const Elf32_Ehdr &ehdr)
+{
+	std::vector<Image::Symbol> symbols;
+
+	// Sanity check.
+	if ((ehdr.e_shnum == 0) || (ehdr.e_shentsize != sizeof(Elf32_Shdr)))
+		return (symbols);
+
+	std::vector<Elf32_Shdr> shdr(ehdr.e_shnum);
+	readAt(fd, shdr.data(), shdr.size()*sizeof(Elf32_Shdr), ehdr.e_shoff);
+	for (const Elf32_Shdr &sh : shdr)
+	{
+		if ((sh.sh_type != SHT_SYMTAB) || (sh.sh_link >= shdr.size()))
+			continue;
+
+		std::vector<Elf32_Sym> syms(sh.sh_size/sizeof(Elf32_Sym));
+		std::vector<char> strtab(shdr[sh.sh_link].sh_size + 1, '\0');
+		readAt(fd, syms.data(), syms.size()*sizeof(Elf32_Sym), sh.sh_offset);
+		readAt(fd, strtab.data(), strtab.size() - 1, shdr[sh.sh_link].sh_offset);
+
+		for (const Elf32_Sym &sym : syms)
+		{
+			unsigned type = ELF32_ST_TYPE(sym.st_info);
+
+			if ((sym.st_name == 0) || (sym.st_name >= strtab.size()) || (sym.st_shndx == SHN_UNDEF))
+				continue;
+			if ((type != STT_NOTYPE) && (type != STT_FUNC) && (type != STT_OBJECT))
+				continue;
+
+			symbols.push_back({&strtab[sym.st_name], sym.st_value, sym.st_size});
+		}
+	}
+
+	return (symbols);
+}
+
+// Builds an image from an ELF32 executable.
+Image Image::fromElf(const std::string &path)
+{
+	Image img;
+	int fd;
+
+	if ((fd = open(path.c_str(), O_RDONLY)) < 0)
+		throw std::invalid_argument("cannot open input file");
+
+	try
+	{
+		img = fromElf(fd);
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+
+	close(fd);
+
+	return (img);
+}
+
+// Builds an image from an open ELF32 executable.
+Image Image::fromElf(int fd)
+{
+	Image img;
+	Elf32_Ehdr ehdr;
+
+	readAt(fd, &ehdr, sizeof(ehdr), 0);
+	checkElf(ehdr);
+
+	img.entry = ehdr.e_entry;
+
+	// Loadable segments.
+	std::vector<Elf32_Phdr> phdr(ehdr.e_phnum);
+	readAt(fd, phdr.data(), phdr.size()*sizeof(Elf32_Phdr), ehdr.e_phoff);
+	for (const Elf32_Phdr &ph : phdr)
+	{
+		if (ph.p_type != PT_LOAD)
+			continue;
+
+		// Sanity check.
+		if (ph.p_filesz > ph.p_memsz)
+			throw std::invalid_argument("invalid loadable segment");
+
+		Segment seg;
+		seg.vaddr = ph.p_vaddr;
+		seg.memsz = ph.p_memsz;
+		seg.data.resize(ph.p_filesz);
+		readAt(fd, seg.data.data(), ph.p_filesz, ph.p_offset);
+		img.segments.push_back(std::move(seg));
+	}
+
+	img.symbols = readElfSymbols(fd, ehdr);
+
+	return (img);
+}
+
+// Builds an image from an assembly file.
+Image Image::fromAsm(const std::string &path)
+{
+	std::ifstream infile(path);
+
+	if (!infile.is_open())
+		throw std::invalid_argument("cannot open input file");
+
+	return (fromAsm(infile));
+}
+
+// Builds an image from assembly source.
+Image Image::fromAsm(std::istream &input, isa32::word_t base)
+{
+	return (fromAsm(input, base, mips32::Mips32Assembler()));
+}
+
+// Builds an image from assembly source with a given assembler.
+Image Image::fromAsm(std::istream &input, isa32::word_t base, const Assembler &assembler)
+{
+	return (fromProgram(assembler.assemble(input, base)));
+}
+
+// Builds an image from an assembled program.
+Image Image::fromProgram(const Program &prog)
+{
+	Image img;
+	Segment seg;
+	const char *p = reinterpret_cast<const char *>(prog.words.data());
+
+	seg.vaddr = prog.base;
+	seg.data.assign(p, p + prog.words.size()*sizeof(isa32::word_t));
+	seg.memsz = seg.data.size();
+	img.entry = prog.entry;
+	img.segments.push_back(std::move(seg));
+
+	for (const Program::Symbol &sym : prog.symbols)
+		img.symbols.push_back({sym.name, sym.value, sym.size});
+
+	return (img);
+}
+
+// Writes exactly a range of a file.
+static void writeAt(int fd, const void *buf, size_t size, off_t offset)
+{
+	if (pwrite(fd, buf, size, offset) != static_cast<ssize_t>(size))
+		throw std::runtime_error("cannot write output file");
+}
+
+// Writes the image in native format.
+void Image::write(int fd) const
+{
+	ImageHeader hdr;
+	std::vector<ImageSegment> segs;
+	std::vector<ImageSymbol> syms;
+	std::string strtab;
+
+	for (const Symbol &sym : symbols)
+	{
+		syms.push_back({static_cast<uint32_t>(strtab.size()), sym.value, sym.size});
+		strtab.append(sym.name).push_back('\0');
+	}
+
+	hdr.magic = VMIMG_MAGIC;
+	hdr.version = VMIMG_VERSION;
+	hdr.entry = entry;
+	hdr.segoff = sizeof(ImageHeader);
+	hdr.nsegments = segments.size();
+	hdr.symoff = hdr.segoff + hdr.nsegments*sizeof(ImageSegment);
+	hdr.nsymbols = syms.size();
+	hdr.stroff = hdr.symoff + hdr.nsymbols*sizeof(ImageSymbol);
+	hdr.strsize = strtab.size();
+
+	// Contents keep the page offset of their address.
+	uint32_t offset = hdr.stroff + hdr.strsize;
+	for (const Segment &seg : segments)
+	{
+		offset = (offset + VMIMG_ALIGN - 1) & ~(VMIMG_ALIGN - 1);
+		offset += seg.vaddr & (VMIMG_ALIGN - 1);
+		segs.push_back({offset, seg.vaddr, static_cast<uint32_t>(seg.data.size()), seg.memsz});
+		offset += seg.data.size();
+	}
+
+	writeAt(fd, &hdr, sizeof(hdr), 0);
+	writeAt(fd, segs.data(), segs.size()*sizeof(ImageSegment), hdr.segoff);
+	writeAt(fd, syms.data(), syms.size()*sizeof(ImageSymbol), hdr.symoff);
+	writeAt(fd, strtab.data(), strtab.size(), hdr.stroff);
+	for (size_t i = 0; i < segments.size(); i++)
+		writeAt(fd, segments[i].data.data(), segments[i].data.size(), segs[i].offset);
+}
+
+// Opens an output file for a writer.
+template<typename F>
+static void writeFile(const std::string &path, F fn)
+{
+	int fd;
+
+	if ((fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+		throw std::invalid_argument("cannot open output file");
+
+	try
+	{
+		fn(fd);
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+
+	close(fd);
+}
+
+// Writes the image in native format to a file.
+void Image::write(const std::string &path) const
+{
+	writeFile(path, [this](int fd) { write(fd); });
+}
+
+// Writes the image as an ELF32 executable.
+void Image::writeElf(int fd) const
+{
+	// Section header indexes.
+	const unsigned symtab = 1 + segments.size();
+	const unsigned strtab = symtab + 1;
+	const unsigned shstrtab = strtab + 1;
+
+	Elf32_Ehdr ehdr;
+	std::vector<Elf32_Phdr> phdr(segments.size());
+	std::vector<Elf32_Shdr> shdr(shstrtab + 1);
+	std::vector<Elf32_Sym> syms(1);
+	std::string strings(1, '\0');
+	std::string names(1, '\0');
+
+	// Adds a section name.
+	auto name = [&names](const char *str) {
+		uint32_t off = names.size();
+		names.append(str).push_back('\0');
+		return (off);
+	};
+
+	memset(&ehdr, 0, sizeof(ehdr));
+	memset(phdr.data(), 0, phdr.size()*sizeof(Elf32_Phdr));
+	memset(shdr.data(), 0, shdr.size()*sizeof(Elf32_Shdr));
+	memset(syms.data(), 0, sizeof(Elf32_Sym));
+
+	// Symbols, in the section of the segment that holds them.
+	for (const Symbol &sym : symbols)
+	{
+		Elf32_Sym esym;
+
+		memset(&esym, 0, sizeof(esym));
+		esym.st_name = strings.size();
+		esym.st_value = sym.value;
+		esym.st_size = sym.size;
+		esym.st_info = ELF32_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+		esym.st_shndx = SHN_ABS;
+		for (size_t i = 0; i < segments.size(); i++)
+		{
+			if ((sym.value >= segments[i].vaddr) && (sym.value - segments[i].vaddr < segments[i].memsz))
+				esym.st_shndx = 1 + i;
+		}
+
+		syms.push_back(esym);
+		strings.append(sym.name).push_back('\0');
+	}
+
+	// Headers and tables come first.
+	uint32_t offset = sizeof(Elf32_Ehdr) + phdr.size()*sizeof(Elf32_Phdr);
+	auto place = [&offset](Elf32_Shdr &sh, uint32_t type, size_t size) {
+		sh.sh_type = type;
+		sh.sh_offset = offset;
+		sh.sh_size = size;
+		sh.sh_addralign = 1;
+		offset += size;
+	};
+
+	place(shdr[symtab], SHT_SYMTAB, syms.size()*sizeof(Elf32_Sym));
+	shdr[symtab].sh_name = name(".symtab");
+	shdr[symtab].sh_link = strtab;
+	shdr[symtab].sh_info = 1;
+	shdr[symtab].sh_entsize = sizeof(Elf32_Sym);
+	shdr[symtab].sh_addralign = sizeof(isa32::word_t);
+	place(shdr[strtab], SHT_STRTAB, strings.size());
+	shdr[strtab].sh_name = name(".strtab");
+	uint32_t load = name(".load");
+	shdr[shstrtab].sh_name = name(".shstrtab");
+	place(shdr[shstrtab], SHT_STRTAB, names.size());
+
+	offset = (offset + 3) & ~3u;
+	uint32_t shoff = offset;
+	offset += shdr.size()*sizeof(Elf32_Shdr);
+
+	// Contents keep the page offset of their address.
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		const Segment &seg = segments[i];
+		Elf32_Phdr &ph = phdr[i];
+		Elf32_Shdr &sh = shdr[1 + i];
+
+		offset = (offset + VMIMG_ALIGN - 1) & ~(VMIMG_ALIGN - 1);
+		offset += seg.vaddr & (VMIMG_ALIGN - 1);
+
+		ph.p_type = PT_LOAD;
+		ph.p_offset = offset;
+		ph.p_vaddr = seg.vaddr;
+		ph.p_paddr = seg.vaddr;
+		ph.p_filesz = seg.data.size();
+		ph.p_memsz = seg.memsz;
+		ph.p_flags = PF_R | PF_W | PF_X;
+		ph.p_align = VMIMG_ALIGN;
+
+		sh.sh_name = load;
+		sh.sh_type = SHT_PROGBITS;
+		sh.sh_flags = SHF_ALLOC | SHF_WRITE | SHF_EXECINSTR;
+		sh.sh_addr = seg.vaddr;
+		sh.sh_offset = offset;
+		sh.sh_size = seg.data.size();
+		sh.sh_addralign = sizeof(isa32::word_t);
+
+		offset += seg.data.size();
+	}
+
+	memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+	ehdr.e_ident[EI_CLASS] = ELFCLASS32;
+	ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr.e_ident[EI_OSABI] = ELFOSABI_NONE;
+	ehdr.e_type = ET_EXEC;
+	ehdr.e_machine = EM_RISCV;
+	ehdr.e_version = EV_CURRENT;
+	ehdr.e_entry = entry;
+	ehdr.e_phoff = phdr.empty() ? 0 : sizeof(Elf32_Ehdr);
+	ehdr.e_shoff = shoff;
+	ehdr.e_ehsize = sizeof(Elf32_Ehdr);
+	ehdr.e_phentsize = sizeof(Elf32_Phdr);
+	ehdr.e_phnum = phdr.size();
+	ehdr.e_shentsize = sizeof(Elf32_Shdr);
+	ehdr.e_shnum = shdr.size();
+	ehdr.e_shstrndx = shstrtab;
+
+	writeAt(fd, &ehdr, sizeof(ehdr), 0);
+	writeAt(fd, phdr.data(), phdr.size()*sizeof(Elf32_Phdr), ehdr.e_phoff);
+	writeAt(fd, syms.data(), shdr[symtab].sh_size, shdr[symtab].sh_offset);
+	writeAt(fd, strings.data(), shdr[strtab].sh_size, shdr[strtab].sh_offset);
+	writeAt(fd, names.data(), shdr[shstrtab].sh_size, shdr[shstrtab].sh_offset);
+	writeAt(fd, shdr.data(), shdr.size()*sizeof(Elf32_Shdr), shoff);
+	for (size_t i = 0; i < segments.size(); i++)
+		writeAt(fd, segments[i].data.data(), segments[i].data.size(), phdr[i].p_offset);
+}
+
+// Writes the image as an ELF32 executable to a file.
+void Image::writeElf(const std::string &path) const
+{
+	writeFile(path, [this](int fd) { writeElf(fd); });
+}
+
+//==============================================================================
+// Shared Image
+//==============================================================================
+
+// Live shared images, by file identity.
+static std::mutex registryLock;
+static std::map<std::string, std::weak_ptr<SharedImage>> registry;
+
+// Creates a shared image from a native image.
+SharedImage::SharedImage(int fd) :
+	fd_(fd)
+{
+	ImageHeader hdr;
+	struct stat st;
+
+	if (fstat(fd, &st) != 0)
+		throw std::invalid_argument("cannot open input file");
+
+	if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+		throw std::invalid_argument("truncated image header");
+
+	// Sanity check.
+	if ((hdr.magic != VMIMG_MAGIC) || (hdr.version != VMIMG_VERSION))
+		throw std::invalid_argument("not a native image");
+
+	segments_.resize(hdr.nsegments);
+	ssize_t segsize = hdr.nsegments*sizeof(ImageSegment);
+	if (pread(fd, segments_.data(), segsize, hdr.segoff) != segsize)
+		throw std::invalid_argument("truncated segment table");
+
+	for (const ImageSegment &seg : segments_)
+	{
+		// Sanity check.
+		if (seg.filesz > seg.memsz)
+			throw std::invalid_argument("invalid image segment");
+
+		// Mapping past the end of the file would fault on first access.
+		if (static_cast<off_t>(seg.offset) + seg.filesz > st.st_size)
+			throw std::invalid_argument("truncated image segment");
+	}
+
+	// Symbols.
+	std::vector<ImageSymbol> syms(hdr.nsymbols);
+	std::vector<char> strtab(hdr.strsize + 1, '\0');
+	ssize_t symsize = hdr.nsymbols*sizeof(ImageSymbol);
+	if ((pread(fd, syms.data(), symsize, hdr.symoff) != symsize) ||
+		(pread(fd, strtab.data(), hdr.strsize, hdr.stroff) != static_cast<ssize_t>(hdr.strsize)))
+		throw std::invalid_argument("truncated symbol table");
+
+	std::shared_ptr<SymbolIndex> symbols = std::make_shared<SymbolIndex>();
+	for (const ImageSymbol &sym : syms)
+	{
+		if (sym.name < hdr.strsize)
+			symbols->add(&strtab[sym.name], sym.value, sym.size);
+	}
+	symbols->build();
+
+	symbols_ = symbols;
+	entry_ = hdr.entry;
+}
+
+// Destroys a shared image.
+SharedImage::~SharedImage()
+{
+	close(fd_);
+}
+
+// Opens a shared image.
+std::shared_ptr<SharedImage> SharedImage::open(const std::string &path)
+{
+	struct stat st;
+	int fd;
+
+	if ((fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC)) < 0)
+		throw std::invalid_argument("cannot open input file");
+
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		throw std::invalid_argument("cannot open input file");
+	}
+
+	// Replaced or modified files are different images.
+	std::string key = path + ":" + std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" +
+		std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec) + ":" +
+		std::to_string(st.st_size);
+
+	std::lock_guard<std::mutex> guard(registryLock);
+
+	std::shared_ptr<SharedImage> image = registry[key].lock();
+	if (image != nullptr)
+	{
+		close(fd);
+		return (image);
+	}
+
+	try
+	{
+		char magic[SELFMAG] = { 0 };
+
+		// Lay out executables as native images, in anonymous memory.
+		if ((pread(fd, magic, SELFMAG, 0) == SELFMAG) && (memcmp(magic, ELFMAG, SELFMAG) == 0))
+		{
+			Image img = Image::fromElf(fd);
+			int memfd;
+
+			if ((memfd = memfd_create("vmimg", MFD_CLOEXEC | MFD_ALLOW_SEALING)) < 0)
+				throw std::runtime_error("cannot create shared image");
+			close(fd);
+			fd = memfd;
+
+			img.write(fd);
+			fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+		}
+
+		image = std::shared_ptr<SharedImage>(new SharedImage(fd));
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+
+	// Drop entries of images no longer in use.
+	for (auto it = registry.begin(); it != registry.end(); )
+		it = it->second.expired() ? registry.erase(it) : std::next(it);
+
+	registry[key] = image;
+
+	return (image);
+}
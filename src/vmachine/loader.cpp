@@ -23,69 +23,206 @@
 //
 
 // Theirs
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <elf.h>
+#include <fcntl.h>
 #include <fstream>
 #include <string>
 #include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 // Ours
-#include <engine.h>
+#include <asm/mips32.h>
 #include <vmachine.h>
+#include <vmachine/image.h>
+#include <config.h>
+#include <utils.h>
 
 using namespace vmachine;
 
-// Starts the virtual machine.
+// Gets the directory of assembled programs.
+static std::string cacheDir(void)
+{
+	const char *dir = getenv("VMACHINE_ASM_CACHE");
+
+	return ((dir != nullptr) ? dir : VMACHINE_ASM_CACHE_DIR);
+}
+
+// Loads an ASM file.
 void VMachine::load(std::string &asmfile)
 {
-	Engine a;
-	std::string line;
-	std::ifstream infile(asmfile);
+	load(asmfile, mips32::Mips32Assembler());
+}
+
+// Loads an ASM file with a given assembler.
+void VMachine::load(std::string &asmfile, const Assembler &assembler)
+{
+	std::ifstream infile(asmfile, std::ios::in | std::ios::binary);
 
 	if (!infile.is_open())
 		throw std::invalid_argument("cannot open input file");
 
-	// Load ASM file.
-	for (isa32::word_t addr = startAddr; std::getline(infile, line); addr += sizeof(isa32::word_t))
+	// Assembled programs are keyed on their source and on the assembler.
+	uint64_t version = assembler.version();
+	const char *language = assembler.name();
+	uint64_t key = hash64(&version, sizeof(version));
+	key = hash64(language, strlen(language), key);
+	std::vector<char> chunk(ASSEMBLER_CHUNK_SIZE);
+	while (infile.read(chunk.data(), chunk.size()) || (infile.gcount() > 0))
+		key = hash64(chunk.data(), infile.gcount(), key);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.vmimg", static_cast<unsigned long long>(key));
+	std::string dir = cacheDir();
+	std::string cached = dir + "/" + name;
+
+	if (access(cached.c_str(), R_OK) == 0)
 	{
-		unsigned inst = a.assembly(line);
-		memory.write(addr, inst);
+		try
+		{
+			loadImage(cached);
+			return;
+		}
+		catch (const std::exception &)
+		{
+			// Damaged entry: assemble again and replace it.
+		}
+	}
+
+	// Read the source again, and commit the program at once.
+	infile.clear();
+	infile.seekg(0);
+	Program prog = assembler.assemble(infile, startAddr);
+	Image img = Image::fromProgram(prog);
+
+	memory.write(prog.base, prog.words.data(), prog.words.size());
+
+	std::shared_ptr<SymbolIndex> index = std::make_shared<SymbolIndex>();
+	for (const Program::Symbol &sym : prog.symbols)
+		index->add(sym.name, sym.value, sym.size);
+	index->build();
+	symbols = index;
+
+	// Drop stale lines of the previous program.
+	icache.flush();
+	dcache.flush();
+
+	core.setPC(prog.entry);
+
+	// Caching is best effort: a read-only cache only costs speed.
+	static std::atomic<unsigned> loads(0);
+	std::string tmp = cached + "." + std::to_string(getpid()) + "." + std::to_string(loads++);
+	mkdir(dir.c_str(), 0755);
+	try
+	{
+		img.write(tmp);
+		if (rename(tmp.c_str(), cached.c_str()) != 0)
+			unlink(tmp.c_str());
+	}
+	catch (const std::exception &)
+	{
+		unlink(tmp.c_str());
 	}
 }
 
-void VMachine::loadFile(std::string &binFile)
+// Loads an ELF32 executable.
+void VMachine::loadFile(std::string &binFile, bool eager)
 {
-	std::ifstream bin(binFile, std::ios::in | std::ios::binary);
-	std::string line;
-	Elf64_Ehdr ehdr;
-	Elf64_Shdr shdrBuffer;
+	Elf32_Ehdr ehdr;
+	struct stat st;
+	int fd;
 
-	if (!bin.is_open())
+	if ((fd = open(binFile.c_str(), O_RDONLY)) < 0)
 		throw std::invalid_argument("cannot open input file");
 
-	bin.read(reinterpret_cast<char*>(&ehdr), sizeof(ehdr));
-	bin.seekg(ehdr.e_shoff, bin.beg);
-	std::vector<Elf64_Shdr> shdr(ehdr.e_shnum);
-
-	for (Elf32_Half i = 0; i < ehdr.e_shnum; i++)
+	try
 	{
-		bin.read(reinterpret_cast<char*>(&shdrBuffer),sizeof(shdrBuffer));
+		if (fstat(fd, &st) != 0)
+			throw std::invalid_argument("cannot open input file");
 
-		shdr[i] = shdrBuffer;
-	}
+		if (pread(fd, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr))
+			throw std::invalid_argument("truncated ELF header");
 
-	for (Elf32_Half i = 0; i < ehdr.e_shnum; i++)
-	{
-		if(shdr[i].sh_flags & SHF_EXECINSTR)
+		checkElf(ehdr);
+
+		std::vector<Elf32_Phdr> phdr(ehdr.e_phnum);
+		ssize_t phsize = ehdr.e_phnum*sizeof(Elf32_Phdr);
+
+		if (pread(fd, phdr.data(), phsize, ehdr.e_phoff) != phsize)
+			throw std::invalid_argument("truncated program headers");
+
+		// Mapping past the end of the file would fault on first access.
+		for (const Elf32_Phdr &ph : phdr)
 		{
-			bin.seekg(shdr[i].sh_offset, bin.beg);
+			if (ph.p_type != PT_LOAD)
+				continue;
 
-			for (isa32::word_t block = startAddr; block < shdr[i].sh_size; block += sizeof(isa32::word_t))
-			{
-				isa32::word_t word;
+			// Sanity check.
+			if (ph.p_filesz > ph.p_memsz)
+				throw std::invalid_argument("invalid loadable segment");
+			if (static_cast<off_t>(ph.p_offset) + ph.p_filesz > st.st_size)
+				throw std::invalid_argument("truncated loadable segment");
+		}
+
+		for (const Elf32_Phdr &ph : phdr)
+		{
+			if (ph.p_type != PT_LOAD)
+				continue;
 
-				bin.read(reinterpret_cast<char*>(&word),sizeof(word));
-				memory.write(block, word);
-			}
+			memory.map(ph.p_vaddr, fd, ph.p_offset, ph.p_filesz);
+			memory.zero(ph.p_vaddr + ph.p_filesz, ph.p_memsz - ph.p_filesz);
 		}
+
+		if (eager)
+			memory.populate(ThreadPool::instance());
+
+		std::shared_ptr<SymbolIndex> index = std::make_shared<SymbolIndex>();
+		for (const Image::Symbol &sym : readElfSymbols(fd, ehdr))
+			index->add(sym.name, sym.value, sym.size);
+		index->build();
+		symbols = index;
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+
+	// Mappings keep their own reference to the file.
+	close(fd);
+
+	// Drop stale lines of the previous image.
+	icache.flush();
+	dcache.flush();
+
+	core.setPC(ehdr.e_entry);
+}
+
+// Loads a native image.
+void VMachine::loadImage(std::string &imgFile)
+{
+	load(SharedImage::open(imgFile));
+}
+
+// Maps a shared image.
+void VMachine::load(const std::shared_ptr<SharedImage> &img)
+{
+	for (const ImageSegment &seg : img->getSegments())
+	{
+		memory.map(seg.vaddr, img->getFd(), seg.offset, seg.filesz);
+		memory.zero(seg.vaddr + seg.filesz, seg.memsz - seg.filesz);
 	}
+
+	image = img;
+	symbols = img->getSymbols();
+
+	// Drop stale lines of the previous image.
+	icache.flush();
+	dcache.flush();
+
+	core.setPC(img->getEntry());
 }
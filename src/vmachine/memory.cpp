@@ -23,9 +23,15 @@
 //
 
 // Theirs
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <stdexcept>
 #include <iomanip>
+#include <sys/mman.h>
+#include <unistd.h>
 
 // Ours
 #include <vmachine/memory.h>
@@ -34,18 +40,235 @@
 Memory::Memory(unsigned size)
 {
     size_ = size;
-    data = new unsigned[size/sizeof(unsigned)];
+    pageSize_ = sysconf(_SC_PAGESIZE);
+
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED)
+        throw std::bad_alloc();
+
+    data = static_cast<unsigned *>(p);
+    pages_ = new uint32_t[(size_ + VMACHINE_PAGE_SIZE - 1)/VMACHINE_PAGE_SIZE]();
+    released_ = 0;
+    faults_ = 0;
 }
 
 // Destroy a memory object.
 Memory::~Memory()
 {
-    delete[] data;
+    for (const Backing &b : backings_)
+    {
+        if (b.fd >= 0)
+            close(b.fd);
+    }
+    delete[] pages_;
+    munmap(data, size_);
+}
+
+// Reads in a run of lazy pages that share their page table entry.
+void Memory::fill(unsigned page, unsigned count, uint32_t entry)
+{
+    char *base = reinterpret_cast<char *>(data);
+    size_t first = static_cast<size_t>(page)*VMACHINE_PAGE_SIZE;
+    size_t last = std::min(first + static_cast<size_t>(count)*VMACHINE_PAGE_SIZE, static_cast<size_t>(size_));
+
+    for (size_t i = entry - 1; i < backings_.size(); i++)
+    {
+        const Backing &b = backings_[i];
+        size_t from = std::max(first, static_cast<size_t>(b.addr));
+        size_t to = std::min(last, b.addr + b.size);
+
+        if ((b.fd < 0) || (from >= to))
+            continue;
+
+        if (pread(b.fd, base + from, to - from, b.offset + (from - b.addr)) != static_cast<ssize_t>(to - from))
+            throw std::runtime_error("cannot read file");
+    }
+}
+
+// Marks a lazy page as resident.
+void Memory::release(unsigned page)
+{
+    for (size_t i = pages_[page] - 1; i < backings_.size(); i++)
+    {
+        Backing &b = backings_[i];
+
+        if ((b.fd < 0) || (page < b.addr/VMACHINE_PAGE_SIZE) || (page > (b.addr + b.size - 1)/VMACHINE_PAGE_SIZE))
+            continue;
+
+        if (--b.pending == 0)
+        {
+            close(b.fd);
+            b.fd = -1;
+            released_++;
+        }
+    }
+
+    pages_[page] = 0;
+}
+
+// Drops released backings and renumbers page table entries.
+void Memory::compact(void)
+{
+    unsigned npages = (size_ + VMACHINE_PAGE_SIZE - 1)/VMACHINE_PAGE_SIZE;
+    std::vector<uint32_t> renumber(backings_.size() + 1);
+    size_t live = 0;
+
+    // An entry moves to the first live backing at or after it.
+    for (size_t i = 0; i < backings_.size(); i++)
+    {
+        renumber[i] = live;
+        if (backings_[i].fd >= 0)
+            backings_[live++] = backings_[i];
+    }
+    renumber[backings_.size()] = live;
+
+    backings_.resize(live);
+    released_ = 0;
+
+    if (live == 0)
+        return;
+
+    for (unsigned page = 0; page < npages; page++)
+    {
+        if (pages_[page] != 0)
+            pages_[page] = renumber[pages_[page] - 1] + 1;
+    }
+}
+
+// Reads in a lazy page.
+void Memory::fault(unsigned page)
+{
+    fill(page, 1, pages_[page]);
+    release(page);
+
+    faults_++;
+}
+
+// Reads in all lazy pages.
+void Memory::populate(ThreadPool &pool)
+{
+    struct Run { unsigned page; unsigned count; uint32_t entry; };
+    const unsigned chunk = std::max(1, VMACHINE_LOAD_CHUNK_SIZE/VMACHINE_PAGE_SIZE);
+    unsigned npages = (size_ + VMACHINE_PAGE_SIZE - 1)/VMACHINE_PAGE_SIZE;
+    std::vector<Run> runs;
+
+    // Split lazy pages into bounded runs with the same entry.
+    for (unsigned page = 0; page < npages; page++)
+    {
+        if (pages_[page] == 0)
+            continue;
+
+        if (runs.empty() || (runs.back().page + runs.back().count != page) ||
+            (runs.back().entry != pages_[page]) || (runs.back().count == chunk))
+            runs.push_back({page, 0, pages_[page]});
+        runs.back().count++;
+    }
+
+    // Runs are disjoint, so they are read in concurrently.
+    pool.run(runs.size(), [this, &runs](size_t i) {
+        fill(runs[i].page, runs[i].count, runs[i].entry);
+    });
+
+    for (const Run &run : runs)
+    {
+        for (unsigned page = run.page; page < run.page + run.count; page++)
+            release(page);
+    }
+
+    // Start reading ahead mapped file pages too.
+    madvise(data, size_, MADV_WILLNEED);
+}
+
+// Reads in lazy pages with pending contents in a range.
+void Memory::settle(unsigned addr, size_t size)
+{
+    if (size == 0)
+        return;
+
+    size_t first = addr;
+    size_t last = first + size;
+
+    for (unsigned page = addr/VMACHINE_PAGE_SIZE; page <= (last - 1)/VMACHINE_PAGE_SIZE; page++)
+    {
+        if (pages_[page] == 0)
+            continue;
+
+        // Pending contents outside the range are kept pending.
+        for (size_t i = pages_[page] - 1; i < backings_.size(); i++)
+        {
+            if ((backings_[i].fd >= 0) && (backings_[i].addr < last) && (first < backings_[i].addr + backings_[i].size))
+            {
+                fault(page);
+                break;
+            }
+        }
+    }
+}
+
+// Prepares a range to be overwritten.
+void Memory::discard(unsigned addr, size_t size)
+{
+    size_t first = addr;
+    size_t last = first + size;
+    size_t start = (first + VMACHINE_PAGE_SIZE - 1)/VMACHINE_PAGE_SIZE;
+    size_t end = last/VMACHINE_PAGE_SIZE;
+
+    if (start >= end)
+    {
+        settle(addr, size);
+        return;
+    }
+
+    // Partial pages keep the contents outside the range.
+    settle(first, start*VMACHINE_PAGE_SIZE - first);
+    settle(end*VMACHINE_PAGE_SIZE, last - end*VMACHINE_PAGE_SIZE);
+
+    for (size_t page = start; page < end; page++)
+    {
+        if (pages_[page] != 0)
+            release(page);
+    }
+}
+
+// Registers a file region to be read in on demand.
+void Memory::defer(unsigned addr, int fd, off_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+
+    // Reclaim released backings once they are the majority.
+    if ((released_ > 0) && (2*released_ >= backings_.size()))
+        compact();
+
+    // The caller may close its descriptor.
+    int dupfd = dup(fd);
+    if (dupfd < 0)
+        throw std::runtime_error(std::string("cannot duplicate file: ") + strerror(errno));
+
+    unsigned last = (addr + size - 1)/VMACHINE_PAGE_SIZE;
+    unsigned pages = last - addr/VMACHINE_PAGE_SIZE + 1;
+
+    backings_.push_back({addr, size, dupfd, offset, pages});
+
+    for (unsigned page = addr/VMACHINE_PAGE_SIZE; page <= last; page++)
+    {
+        if (pages_[page] == 0)
+            pages_[page] = backings_.size();
+    }
+}
+
+// Asserts that a range lies within the memory.
+void Memory::check(unsigned addr, size_t size) const
+{
+    if ((addr > size_) || (size > size_ - addr))
+        throw std::range_error("invalid memory range");
 }
 
 // Dumps the contents of the memory.
 void Memory::dump(std::ostream &outfile)
 {
+    settle(0, size_);
+
     for (unsigned i = 0; i < size_/sizeof(unsigned); i++)
     {
         if (data[i] == 0)
@@ -64,7 +287,9 @@ unsigned Memory::read(unsigned addr)
     // Invalid address.
     if (addr >= size_)
         throw std::range_error("invalid memory address");
-    // TODO
+
+    if (pages_[addr/VMACHINE_PAGE_SIZE] != 0)
+        fault(addr/VMACHINE_PAGE_SIZE);
 
     return (data[addr/sizeof(unsigned)]);
 }
@@ -76,5 +301,80 @@ void Memory::write(unsigned addr, unsigned word)
     if (addr >= size_)
         throw std::range_error("invalid memory address");
 
+    if (pages_[addr/VMACHINE_PAGE_SIZE] != 0)
+        fault(addr/VMACHINE_PAGE_SIZE);
+
     data[addr/sizeof(unsigned)] = word;
-}
\ No newline at end of file
+}
+
+// Writes consecutive words to the memory.
+void Memory::write(unsigned addr, const unsigned *words, size_t count)
+{
+    size_t size = count*sizeof(unsigned);
+
+    check(addr, size);
+    discard(addr, size);
+
+    memcpy(reinterpret_cast<char *>(data) + addr, words, size);
+}
+
+// Loads a region of a file into the memory.
+void Memory::map(unsigned addr, int fd, off_t offset, size_t size)
+{
+    char *base = reinterpret_cast<char *>(data);
+    size_t first = addr;
+    size_t last = addr + size;
+
+    check(addr, size);
+    discard(addr, size);
+
+    // Map whole pages, if the file and the memory agree on page offsets.
+    if (((addr - offset) % pageSize_) == 0)
+    {
+        size_t start = (first + pageSize_ - 1) & ~(pageSize_ - 1);
+        size_t end = last & ~(pageSize_ - 1);
+
+        if (start < end)
+        {
+            void *p = mmap(base + start, end - start, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_FIXED, fd, offset + (start - first));
+            if (p == MAP_FAILED)
+                throw std::runtime_error(std::string("cannot map file: ") + strerror(errno));
+
+            // Defer the unaligned tail below.
+            defer(end, fd, offset + (end - first), last - end);
+            last = start;
+        }
+    }
+
+    // Defer whatever could not be mapped.
+    defer(first, fd, offset, last - first);
+}
+
+// Zero-fills a range of the memory.
+void Memory::zero(unsigned addr, size_t size)
+{
+    char *base = reinterpret_cast<char *>(data);
+    size_t first = addr;
+    size_t last = addr + size;
+    size_t start = (first + pageSize_ - 1) & ~(pageSize_ - 1);
+    size_t end = last & ~(pageSize_ - 1);
+
+    check(addr, size);
+    discard(addr, size);
+
+    if (start >= end)
+    {
+        memset(base + first, 0, size);
+        return;
+    }
+
+    // Fresh anonymous pages are zero-filled on demand.
+    void *p = mmap(base + start, end - start, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED)
+        throw std::runtime_error(std::string("cannot zero memory: ") + strerror(errno));
+
+    memset(base + first, 0, start - first);
+    memset(base + end, 0, last - end);
+}
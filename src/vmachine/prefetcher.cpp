@@ -0,0 +1,265 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <stdexcept>
+
+// Ours
+#include <vmachine/prefetcher.h>
+
+//==============================================================================
+// Prefetch Queue
+//==============================================================================
+
+// Creates a prefetch queue.
+PrefetchQueue::PrefetchQueue(unsigned capacity)
+{
+	// Sanity check.
+	if (capacity == 0)
+		throw std::invalid_argument("invalid prefetch queue capacity");
+
+	capacity_ = capacity;
+	lines = new isa32::word_t[capacity];
+	head_ = 0;
+	count_ = 0;
+}
+
+// Destroys a prefetch queue.
+PrefetchQueue::~PrefetchQueue()
+{
+	delete[] lines;
+}
+
+// Enqueues a line address.
+bool PrefetchQueue::push(isa32::word_t line)
+{
+	if (count_ == capacity_)
+		return (false);
+
+	for (unsigned i = 0; i < count_; i++)
+	{
+		if (lines[(head_ + i) % capacity_] == line)
+			return (false);
+	}
+
+	lines[(head_ + count_++) % capacity_] = line;
+
+	return (true);
+}
+
+// Dequeues the oldest line address.
+bool PrefetchQueue::pop(isa32::word_t &line)
+{
+	if (count_ == 0)
+		return (false);
+
+	line = lines[head_];
+	head_ = (head_ + 1) % capacity_;
+	count_--;
+
+	return (true);
+}
+
+// Removes a line address, if queued.
+bool PrefetchQueue::remove(isa32::word_t line)
+{
+	for (unsigned i = 0; i < count_; i++)
+	{
+		if (lines[(head_ + i) % capacity_] != line)
+			continue;
+
+		// Shift younger entries down.
+		for (unsigned j = i + 1; j < count_; j++)
+			lines[(head_ + j - 1) % capacity_] = lines[(head_ + j) % capacity_];
+		count_--;
+
+		return (true);
+	}
+
+	return (false);
+}
+
+//==============================================================================
+// Next-Line Prefetcher
+//==============================================================================
+
+// Observes a demand access.
+void NextLinePrefetcher::train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue)
+{
+	isa32::word_t line = addr >> lineShift_;
+
+	((void) pc);
+
+	if (event == HIT)
+		return;
+
+	for (unsigned i = 0; i < degree_; i++)
+		queue.push(line + distance_ + i);
+}
+
+//==============================================================================
+// Stride Prefetcher
+//==============================================================================
+
+// Creates a stride prefetcher.
+StridePrefetcher::StridePrefetcher(unsigned degree, unsigned distance) :
+	Prefetcher(degree, distance)
+{
+	for (unsigned i = 0; i < TABLE_SIZE; i++)
+		table[i].valid = false;
+}
+
+// Observes a demand access.
+void StridePrefetcher::train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue)
+{
+	Entry &e = table[(pc >> 2) & (TABLE_SIZE - 1)];
+
+	((void) event);
+
+	// Allocate entry.
+	if (!e.valid || (e.pc != pc))
+	{
+		e.pc = pc;
+		e.addr = addr;
+		e.stride = 0;
+		e.state = INITIAL;
+		e.valid = true;
+		return;
+	}
+
+	int32_t stride = static_cast<int32_t>(addr - e.addr);
+	bool correct = (stride == e.stride);
+
+	switch (e.state)
+	{
+		case INITIAL:
+			e.state = (correct) ? STEADY : TRANSIENT;
+			break;
+		case TRANSIENT:
+			e.state = (correct) ? STEADY : NO_PREDICTION;
+			break;
+		case STEADY:
+			e.state = (correct) ? STEADY : INITIAL;
+			break;
+		case NO_PREDICTION:
+			e.state = (correct) ? TRANSIENT : NO_PREDICTION;
+			break;
+		default:
+			break;
+	}
+
+	// The stride is kept on a first misprediction in steady state.
+	if (!correct && (e.state != INITIAL))
+		e.stride = stride;
+	e.addr = addr;
+
+	if ((e.state != STEADY) || (e.stride == 0))
+		return;
+
+	for (unsigned i = 0; i < degree_; i++)
+	{
+		isa32::word_t target = addr + e.stride*static_cast<int32_t>(distance_ + i);
+
+		queue.push(target >> lineShift_);
+	}
+}
+
+//==============================================================================
+// Stream Prefetcher
+//==============================================================================
+
+// Creates a stream prefetcher.
+StreamPrefetcher::StreamPrefetcher(unsigned degree, unsigned distance) :
+	Prefetcher(degree, distance),
+	clock_(0)
+{
+	for (unsigned i = 0; i < STREAMS_NUM; i++)
+		streams[i].valid = false;
+}
+
+// Observes a demand access.
+void StreamPrefetcher::train(isa32::word_t addr, isa32::word_t pc, Event event, PrefetchQueue &queue)
+{
+	isa32::word_t line = addr >> lineShift_;
+	Stream *s = nullptr;
+	Stream *victim = &streams[0];
+
+	((void) pc);
+
+	if (event == HIT)
+		return;
+
+	// Find the stream this line belongs to.
+	for (unsigned i = 0; i < STREAMS_NUM; i++)
+	{
+		Stream &t = streams[i];
+
+		if (!t.valid)
+		{
+			if (victim->valid)
+				victim = &t;
+			continue;
+		}
+
+		int32_t delta = static_cast<int32_t>(line - t.head);
+
+		if ((delta != 0) && (delta >= -WINDOW) && (delta <= WINDOW))
+		{
+			s = &t;
+			break;
+		}
+
+		if (victim->valid && ((clock_ - t.stamp) > (clock_ - victim->stamp)))
+			victim = &t;
+	}
+
+	// Start a new stream.
+	if (s == nullptr)
+	{
+		victim->head = line;
+		victim->direction = 0;
+		victim->confidence = 0;
+		victim->stamp = ++clock_;
+		victim->valid = true;
+		return;
+	}
+
+	int32_t direction = (static_cast<int32_t>(line - s->head) > 0) ? 1 : -1;
+
+	if (direction == s->direction)
+		s->confidence++;
+	else
+	{
+		s->direction = direction;
+		s->confidence = 1;
+	}
+	s->head = line;
+	s->stamp = ++clock_;
+
+	if (s->confidence < CONFIRMATIONS)
+		return;
+
+	for (unsigned i = 0; i < degree_; i++)
+		queue.push(line + direction*static_cast<int32_t>(distance_ + i));
+}
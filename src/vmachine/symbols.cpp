@@ -0,0 +1,92 @@
+//
+//  MIT License
+//
+// Copyright(c) 2011-2020 The Maintainers of Nanvix
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Theirs
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Ours
+#include <vmachine/symbols.h>
+
+using namespace vmachine;
+
+// Adds a symbol.
+void SymbolIndex::add(const std::string &name, isa32::word_t addr, isa32::word_t size)
+{
+	symbols_.push_back({addr, size, static_cast<uint32_t>(names_.size())});
+	names_.insert(names_.end(), name.c_str(), name.c_str() + name.size() + 1);
+}
+
+// Sorts the index.
+void SymbolIndex::build(void)
+{
+	std::sort(symbols_.begin(), symbols_.end(), [](const Symbol &a, const Symbol &b) {
+		return ((a.addr < b.addr) || ((a.addr == b.addr) && (a.size > b.size)));
+	});
+
+	symbols_.erase(
+		std::unique(symbols_.begin(), symbols_.end(), [](const Symbol &a, const Symbol &b) {
+			return (a.addr == b.addr);
+		}),
+		symbols_.end()
+	);
+	symbols_.shrink_to_fit();
+}
+
+// Looks up the symbol that contains an address.
+const SymbolIndex::Symbol *SymbolIndex::lookup(isa32::word_t addr) const
+{
+	auto it = std::upper_bound(symbols_.begin(), symbols_.end(), addr, [](isa32::word_t a, const Symbol &sym) {
+		return (a < sym.addr);
+	});
+
+	if (it == symbols_.begin())
+		return (nullptr);
+
+	const Symbol &sym = *(--it);
+
+	if ((sym.size != 0) && (addr - sym.addr >= sym.size))
+		return (nullptr);
+
+	return (&sym);
+}
+
+// Describes an address as symbol+offset.
+std::string SymbolIndex::describe(isa32::word_t addr) const
+{
+	char buf[16];
+	const Symbol *sym = lookup(addr);
+
+	if (sym == nullptr)
+	{
+		snprintf(buf, sizeof(buf), "0x%08x", addr);
+		return (buf);
+	}
+
+	snprintf(buf, sizeof(buf), "+0x%x", addr - sym->addr);
+
+	return (getName(*sym) + std::string(buf));
+}
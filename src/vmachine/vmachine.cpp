@@ -37,8 +37,31 @@ void VMachine::start(void)
 	core.run();
 }
 
+// Reports performance statistics.
+void VMachine::report(std::ostream &outfile)
+{
+	uint64_t cycles = core.getCycles();
+	uint64_t instructions = core.getInstructions();
+	double ipc = (cycles == 0) ? 0.0 : static_cast<double>(instructions)/cycles;
+	double cpi = (instructions == 0) ? 0.0 : static_cast<double>(cycles)/instructions;
+
+	outfile << std::dec;
+	outfile << "cycles "        << cycles                  << std::endl;
+	outfile << "instructions "  << instructions            << std::endl;
+	outfile << "ipc "           << ipc                     << std::endl;
+	outfile << "cpi "           << cpi                     << std::endl;
+	outfile << "pc "            << symbols->describe(core.getPC()) << std::endl;
+	outfile << "icache.hits "   << icache.getHits()        << std::endl;
+	outfile << "icache.misses " << icache.getMisses()      << std::endl;
+	outfile << "icache.buffer " << icache.getBufferHits()  << std::endl;
+	outfile << "dcache.hits "   << dcache.getHits()        << std::endl;
+	outfile << "dcache.misses " << dcache.getMisses()      << std::endl;
+}
+
 // Shutdowns the virtual machine.
 void VMachine::shutdown(std::ostream &outfile)
 {
 	memory.dump(outfile);
+
+	report(outfile);
 }
\ No newline at end of file